@@ -1,17 +1,29 @@
+import BatchRunner;
+import BenchRunner;
+import FanOut;
 import Gui;
 import Log;
 import N64;
 import RDP;
+import RDPCapture;
+import Trace;
 
 import <iostream>;
 import <optional>;
+import <span>;
 import <string>;
+import <string_view>;
 
 int main(int argc, char* argv[])
 {
 	/* CLI arguments (beyond executable path):
 	   1; path to rom (optional)
 	   2; path to IPL boot rom (optional)
+	   Alternatively, '--batch' followed by the batch runner's arguments runs a directory of test roms headlessly,
+	   '--fanout' followed by its arguments runs input scripts from a shared checkpoint in forked processes,
+	   '--bench' followed by its arguments runs microbenchmarks of the emulator's hot kernels,
+	   '--replay-rdp' followed by its arguments replays a capture of RDP commands through an RDP implementation,
+	   and '--decode-trace <file>' prints a binary trace as text.
 	*/
 	std::optional<std::string> rom_path, ipl_path;
 	if (argc > 1) {
@@ -21,10 +33,27 @@ int main(int argc, char* argv[])
 		ipl_path = argv[2];
 	}
 
+	if (argc > 1 && std::string_view(argv[1]) == "--decode-trace") {
+		return Trace::Decode(std::span(argv + 2, argc - 2));
+	}
+
 	if (!Log::Init()) {
 		std::cerr << "[warning] Failed to initialize logging.\n";
 	}
 
+	if (argc > 1 && std::string_view(argv[1]) == "--batch") {
+		return BatchRunner::Run(std::span(argv + 2, argc - 2));
+	}
+	if (argc > 1 && std::string_view(argv[1]) == "--bench") {
+		return BenchRunner::Run(std::span(argv + 2, argc - 2));
+	}
+	if (argc > 1 && std::string_view(argv[1]) == "--fanout") {
+		return FanOut::Run(std::span(argv + 2, argc - 2));
+	}
+	if (argc > 1 && std::string_view(argv[1]) == "--replay-rdp") {
+		return RDPCapture::Replay(std::span(argv + 2, argc - 2));
+	}
+
 	if (!Gui::Init()) {
 		std::cerr << "[fatal] Failed to initialize GUI.\n";
 		exit(1);
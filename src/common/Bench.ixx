@@ -0,0 +1,70 @@
+export module Bench;
+
+import Util;
+
+import <algorithm>;
+import <array>;
+import <chrono>;
+import <format>;
+import <iostream>;
+import <string>;
+import <string_view>;
+
+/* Microbenchmark harness for the emulator's hot kernels, run with '--bench' (see BenchRunner). Each module measures
+   its own kernels through a RunBenchmarks function, so that they need not be exported. An operation is repeated
+   in batches, doubling the batch size until a batch takes at least 'min_batch_time'; then 'num_batches' batches
+   of that size are timed. The median time per operation is reported, along with the fastest and slowest batch,
+   so that a change can be judged against the run-to-run noise. */
+namespace Bench
+{
+	export
+	{
+		template<typename T> void Consume(T value); /* keeps a result from being optimized away */
+		void Measure(std::string_view name, auto&& op); /* 'op' is called with the index of the operation */
+		void SetFilter(std::string_view filter); /* only benchmarks whose name contains 'filter' are run */
+	}
+
+	using Clock = std::chrono::steady_clock;
+
+	constexpr std::chrono::nanoseconds min_batch_time = std::chrono::milliseconds(20);
+	constexpr size_t num_batches = 11;
+
+	thread_local std::string name_filter;
+	thread_local volatile u64 sink;
+}
+
+template<typename T>
+void Bench::Consume(T value)
+{
+	sink = sink + u64(value);
+}
+
+void Bench::Measure(std::string_view name, auto&& op)
+{
+	if (!name.contains(name_filter)) {
+		return;
+	}
+	auto TimeBatch = [&](u64 num_ops) {
+		Clock::time_point start = Clock::now();
+		for (u64 i = 0; i < num_ops; ++i) {
+			op(i);
+		}
+		return Clock::now() - start;
+	};
+	u64 batch_size = 1;
+	while (TimeBatch(batch_size) < min_batch_time) {
+		batch_size *= 2;
+	}
+	std::array<f64, num_batches> ns_per_op;
+	for (f64& ns : ns_per_op) {
+		ns = std::chrono::duration<f64, std::nano>(TimeBatch(batch_size)).count() / f64(batch_size);
+	}
+	std::ranges::sort(ns_per_op);
+	std::cout << std::format("{:<40} {:>10.2f} ns/op  (min {:.2f}, max {:.2f})\n",
+		name, ns_per_op[num_batches / 2], ns_per_op.front(), ns_per_op.back());
+}
+
+void Bench::SetFilter(std::string_view filter)
+{
+	name_filter = filter;
+}
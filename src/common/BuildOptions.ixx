@@ -4,27 +4,56 @@ import <string_view>;
 
 export
 {
-	constexpr bool enable_file_logging = false;
+	/* The CPU exception, DMA and IO categories of the file log can be switched on and off while emulating
+	   (Debug > Logging, or Log::SetEnabled), and cost nothing while off; below are their initial states. The log
+	   file is created when a category is first switched on. Instruction logging formats the operands in every
+	   instruction handler, so it is only a build option. */
+	constexpr bool enable_file_logging = true;
 
 	constexpr bool log_cpu_instructions = enable_file_logging && false;
-	constexpr bool log_cpu_exceptions   = enable_file_logging && true;
-	constexpr bool log_dma              = enable_file_logging && true;
-	constexpr bool log_io_all           = enable_file_logging && true;
-	constexpr bool log_io_ai            = enable_file_logging && (log_io_all || true);
-	constexpr bool log_io_mi            = enable_file_logging && (log_io_all || true);
-	constexpr bool log_io_pi            = enable_file_logging && (log_io_all || true);
-	constexpr bool log_io_rdram         = enable_file_logging && (log_io_all || true);
-	constexpr bool log_io_ri            = enable_file_logging && (log_io_all || true);
-	constexpr bool log_io_si            = enable_file_logging && (log_io_all || true);
-	constexpr bool log_io_vi            = enable_file_logging && (log_io_all || true);
-	constexpr bool log_io_rdp           = enable_file_logging && (log_io_all || true);
-	constexpr bool log_io_rsp           = enable_file_logging && (log_io_all || true);
+	constexpr bool log_cpu_exceptions   = enable_file_logging && false;
+	constexpr bool log_dma              = enable_file_logging && false;
+	constexpr bool log_io_all           = enable_file_logging && false;
+	constexpr bool log_io_ai            = enable_file_logging && (log_io_all || false);
+	constexpr bool log_io_mi            = enable_file_logging && (log_io_all || false);
+	constexpr bool log_io_pi            = enable_file_logging && (log_io_all || false);
+	constexpr bool log_io_si            = enable_file_logging && (log_io_all || false);
+	constexpr bool log_io_vi            = enable_file_logging && (log_io_all || false);
+	constexpr bool log_io_rdp           = enable_file_logging && (log_io_all || false);
+	constexpr bool log_io_rsp           = enable_file_logging && (log_io_all || false);
 	constexpr bool log_rsp_instructions = enable_file_logging && false;
 
-	constexpr std::string_view log_path = "F:\\n64.log";
+	constexpr std::string_view log_path = "n64.log";
+
+	/* Write the instruction, IO, DMA and exception logs as binary records to a ring file instead of as text (see
+	   Trace). Instructions are then logged by name only; their operands are not formatted. */
+	constexpr bool trace_to_binary_file = enable_file_logging && false;
+	constexpr bool format_cpu_instructions = log_cpu_instructions && !trace_to_binary_file;
+	constexpr bool format_rsp_instructions = log_rsp_instructions && !trace_to_binary_file;
+	constexpr std::string_view trace_path = "n64.trace";
+
+	constexpr bool profile_guest = false; /* see Profiler */
+	constexpr std::string_view profile_path = "n64.folded";
+
+	constexpr bool instruction_histograms = false; /* see InstructionHistogram */
+	constexpr std::string_view instruction_histogram_path = "instructions.csv";
+
+	constexpr bool time_subsystems = false; /* see FrameTiming */
+
+	constexpr bool capture_rdp_commands = false; /* see RDPCapture */
+	constexpr std::string_view rdp_capture_path = "n64.rdpcapture";
 
 	constexpr bool skip_boot_rom = true;
 
+	constexpr bool skip_idle_loops = true;
+
 	constexpr bool interpret_cpu = false;
 	constexpr bool recompile_cpu = !interpret_cpu;
+
+	/* Interpret code until it is hot, then compile it (see VR4300::Recompiler::Run). Off until the emitter is complete. */
+	constexpr bool tiered_cpu = recompile_cpu && false;
+
+	constexpr bool persist_recompiled_blocks = recompile_cpu && false; /* see VR4300::Recompiler::SaveBlockCache */
+
+	constexpr bool write_perf_map = recompile_cpu && false; /* Linux only; see VR4300::Recompiler::perf_map */
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+module FrameTiming;
+
+namespace FrameTiming
+{
+	void EndFrame()
+	{
+		Enter(current_unit); /* brings the time of the current unit up to date */
+		Frame frame;
+		for (size_t i = 0; i < num_units; ++i) {
+			frame.unit_ms[i] = std::chrono::duration<f32, std::milli>(unit_time_this_frame[i]).count();
+		}
+		frame.total_ms = std::chrono::duration<f32, std::milli>(unit_start_time - frame_start_time).count();
+		frame_start_time = unit_start_time;
+		unit_time_this_frame.fill({});
+		if (frames.size() == max_frames) {
+			frames.erase(frames.begin(), frames.begin() + max_frames / 2);
+		}
+		frames.push_back(frame);
+	}
+
+
+	std::span<Frame const> GetFrames()
+	{
+		return frames;
+	}
+
+
+	void Reset()
+	{
+		current_unit = Unit::Other;
+		unit_start_time = frame_start_time = Clock::now();
+		unit_time_this_frame.fill({});
+		frames.clear();
+	}
+
+
+	std::string StatsToJson()
+	{
+		auto StatsOf = [](std::vector<f32>& ms) {
+			std::ranges::sort(ms);
+			auto Percentile = [&](f64 p) { return ms[size_t(p * f64(ms.size() - 1) + 0.5)]; };
+			f64 sum = 0.0;
+			for (f32 t : ms) {
+				sum += t;
+			}
+			return std::format("{{\"mean\":{:.3f},\"p50\":{:.3f},\"p90\":{:.3f},\"p99\":{:.3f},\"max\":{:.3f}}}",
+				sum / f64(ms.size()), Percentile(0.5), Percentile(0.9), Percentile(0.99), ms.back());
+		};
+
+		std::string json = std::format("{{\"frames\":{}", frames.size());
+		if (!frames.empty()) {
+			std::vector<f32> ms(frames.size());
+			std::ranges::transform(frames, ms.begin(), [](Frame const& frame) { return frame.total_ms; });
+			json += std::format(",\"total\":{}", StatsOf(ms));
+			for (size_t i = 0; i < num_units; ++i) {
+				std::ranges::transform(frames, ms.begin(), [i](Frame const& frame) { return frame.unit_ms[i]; });
+				json += std::format(",\"{}\":{}", UnitToStr(Unit(i)), StatsOf(ms));
+			}
+		}
+		return json + "}";
+	}
+}
@@ -0,0 +1,93 @@
+export module FrameTiming;
+
+import BuildOptions;
+import Util;
+
+import <algorithm>;
+import <array>;
+import <chrono>;
+import <format>;
+import <span>;
+import <string>;
+import <string_view>;
+import <utility>;
+import <vector>;
+
+/* Host time accounting per subsystem, enabled with 'time_subsystems' in BuildOptions. The emulation thread is
+   attributed to one unit at a time; Enter switches to another unit, and a Scope enters a unit for its lifetime
+   and then returns to the previous one (e.g. RDP command submission, which happens while the CPU or RSP runs, is
+   not counted towards them). The units thus add up to the frame time. Times are collected per emulated frame (VI
+   field), for the GUI's frame timing overlay and the batch runner's report. */
+namespace FrameTiming
+{
+	export
+	{
+		enum class Unit {
+			Other, Cpu, Rsp, Events, Rdp, Present, Wait
+		};
+
+		constexpr size_t num_units = std::to_underlying(Unit::Wait) + 1;
+
+		struct Frame {
+			std::array<f32, num_units> unit_ms;
+			f32 total_ms;
+		};
+
+		Unit Enter(Unit unit); /* returns the unit that was left */
+		void EndFrame();
+		std::span<Frame const> GetFrames(); /* oldest first */
+		void Reset();
+		std::string StatsToJson(); /* percentiles of each unit's time per frame */
+		constexpr std::string_view UnitToStr(Unit unit);
+
+		class Scope
+		{
+		public:
+			explicit Scope(Unit unit) : prev_unit(Enter(unit)) {}
+			~Scope() { Enter(prev_unit); }
+			Scope(Scope const&) = delete;
+			Scope& operator=(Scope const&) = delete;
+
+		private:
+			Unit prev_unit;
+		};
+	}
+
+	using Clock = std::chrono::steady_clock;
+
+	constexpr size_t max_frames = 60 * 60 * 10; /* the oldest half is dropped when full */
+
+	thread_local Unit current_unit = Unit::Other;
+	thread_local Clock::time_point unit_start_time = Clock::now();
+	thread_local Clock::time_point frame_start_time = Clock::now();
+	thread_local std::array<Clock::duration, num_units> unit_time_this_frame;
+	thread_local std::vector<Frame> frames;
+}
+
+FrameTiming::Unit FrameTiming::Enter(Unit unit)
+{
+	/* Defined here so that it compiles away at the call sites when accounting is disabled */
+	if constexpr (time_subsystems) {
+		Clock::time_point now = Clock::now();
+		unit_time_this_frame[std::to_underlying(current_unit)] += now - unit_start_time;
+		unit_start_time = now;
+		return std::exchange(current_unit, unit);
+	}
+	else {
+		return unit;
+	}
+}
+
+constexpr std::string_view FrameTiming::UnitToStr(Unit unit)
+{
+	switch (unit) {
+	case Unit::Other: return "other";
+	case Unit::Cpu: return "cpu";
+	case Unit::Rsp: return "rsp";
+	case Unit::Events: return "events";
+	case Unit::Rdp: return "rdp";
+	case Unit::Present: return "present";
+	case Unit::Wait: return "wait";
+	default: std::unreachable();
+	}
+}
@@ -0,0 +1,44 @@
+export module InstructionHistogram;
+
+import Util;
+
+import <array>;
+import <format>;
+import <ostream>;
+import <string_view>;
+
+/* Execution counts of the instructions of one instruction class (e.g. VR4300 COP1), indexed by the value of the
+   instruction enum. Incremented by the EXEC_*_INSTR macros of the instruction decoders when 'instruction_histograms'
+   is set in BuildOptions. The name of an instruction is recorded the first time it is executed, so that the
+   decoders need no table of names. */
+export class InstructionHistogram
+{
+public:
+	static constexpr size_t max_instructions = 256;
+
+	void Increment(size_t index, std::string_view name)
+	{
+		if (counts[index]++ == 0) {
+			names[index] = name;
+		}
+	}
+
+	void Reset()
+	{
+		counts.fill(0);
+	}
+
+	/* One 'cpu,class,instruction,count' line per instruction that has been executed */
+	void WriteCsv(std::ostream& os, std::string_view cpu, std::string_view instr_class) const
+	{
+		for (size_t i = 0; i < max_instructions; ++i) {
+			if (counts[i] > 0) {
+				os << std::format("{},{},{},{}\n", cpu, instr_class, names[i], counts[i]);
+			}
+		}
+	}
+
+private:
+	std::array<u64, max_instructions> counts{};
+	std::array<std::string_view, max_instructions> names{};
+};
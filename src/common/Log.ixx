@@ -1,21 +1,35 @@
 export module Log;
 
 import BuildOptions;
+import Trace;
 import Util;
 
+import <algorithm>;
+import <array>;
 import <concepts>;
 import <format>;
 import <fstream>;
 import <iostream>;
+import <mutex>;
 import <source_location>;
 import <string>;
 import <string_view>;
+import <utility>;
 
 namespace Log
 {
 	export {
+		/* Categories that can be switched on and off while emulating. The hot functions that log them come in
+		   logging and non-logging variants, and switching a category swaps which variant is called. */
+		enum class Category {
+			CpuExceptions, Dma, IoAi, IoMi, IoPi, IoRdp, IoRsp, IoSi, IoVi
+		};
+
+		constexpr size_t num_categories = std::to_underlying(Category::IoVi) + 1;
+
+		constexpr std::string_view CategoryToStr(Category category);
 		void CpuException(const auto& exception);
-		void CpuInstruction(u32 instr_phys_addr, const auto& instr_output);
+		void CpuInstruction(u32 instr_phys_addr, const auto& instr_output, u32 instr_code = 0);
 		void CpuRead(u32 phys_addr, std::integral auto value);
 		void CpuWrite(u32 phys_addr, std::integral auto value);
 		void Dma(const auto& output);
@@ -24,21 +38,47 @@ namespace Log
 		void Info(const auto& output);
 		bool Init();
 		void IoRead(std::string_view loc, std::string_view reg, std::integral auto value);
+		bool IsEnabled(Category category);
 		void IoWrite(std::string_view loc, std::string_view reg, std::integral auto value);
-		void RspInstruction(u32 pc, const auto& instr_output);
+		void RspInstruction(u32 pc, const auto& instr_output, u32 instr_code = 0);
 		void RspRead(u32 dmem_addr, std::integral auto value);
 		void RspWrite(u32 dmem_addr, std::integral auto value);
+		void SetEnabled(Category category, bool enabled);
 		void Warning(const auto& output);
 	}
 
 	void ConsoleOut(const auto& output);
 	void FileOut(const auto& output);
+	bool OpenFile();
 
+	/* Per thread, like the function pointers that are selected from it */
+	thread_local std::array<bool, num_categories> enabled_categories = {
+		log_cpu_exceptions, log_dma, log_io_ai, log_io_mi, log_io_pi, log_io_rdp, log_io_rsp, log_io_si, log_io_vi
+	};
+
+	/* One file for all machines of the process; guarded by 'file_log_mutex' */
+	std::mutex file_log_mutex;
 	std::ofstream file_log;
 	std::string prev_file_output;
 	u64 file_output_repeat_counter;
 }
 
+constexpr std::string_view Log::CategoryToStr(Category category)
+{
+	switch (category) {
+	case Category::CpuExceptions: return "CPU exceptions";
+	case Category::Dma: return "DMA";
+	case Category::IoAi: return "AI IO";
+	case Category::IoMi: return "MI IO";
+	case Category::IoPi: return "PI IO";
+	case Category::IoRdp: return "RDP IO";
+	case Category::IoRsp: return "RSP IO";
+	case Category::IoSi: return "SI IO";
+	case Category::IoVi: return "VI IO";
+	default: std::unreachable();
+	}
+}
+
 void Log::ConsoleOut(const auto& output)
 {
 	std::cout << output << '\n';
@@ -46,27 +86,52 @@ void Log::ConsoleOut(const auto& output)
 
 void Log::CpuException(const auto& exception)
 {
-	FileOut(std::format("EXCEPTION; {}", exception));
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::CpuException, 0, 0, exception);
+	}
+	else {
+		FileOut(std::format("EXCEPTION; {}", exception));
+	}
 }
 
-void Log::CpuInstruction(u32 instr_phys_addr, const auto& instr_output)
+void Log::CpuInstruction(u32 instr_phys_addr, const auto& instr_output, u32 instr_code)
 {
-	FileOut(std::format("CPU; ${:08X}  {}", instr_phys_addr, instr_output));
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::CpuInstruction, instr_phys_addr, instr_code, instr_output);
+	}
+	else {
+		FileOut(std::format("CPU; ${:08X}  {}", instr_phys_addr, instr_output));
+	}
 }
 
 void Log::CpuRead(u32 phys_addr, std::integral auto value)
 {
-	FileOut(std::format("CPU READ; ${:0X} from ${:08X}", MakeUnsigned(value), phys_addr));
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::CpuRead, phys_addr, u64(MakeUnsigned(value)), {});
+	}
+	else {
+		FileOut(std::format("CPU READ; ${:0X} from ${:08X}", MakeUnsigned(value), phys_addr));
+	}
 }
 
 void Log::CpuWrite(u32 phys_addr, std::integral auto value)
 {
-	FileOut(std::format("CPU WRITE; ${:0X} to ${:08X}", MakeUnsigned(value), phys_addr));
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::CpuWrite, phys_addr, u64(MakeUnsigned(value)), {});
+	}
+	else {
+		FileOut(std::format("CPU WRITE; ${:0X} to ${:08X}", MakeUnsigned(value), phys_addr));
+	}
 }
 
 void Log::Dma(const auto& output)
 {
-	FileOut(std::format("INIT DMA; {}", output));
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::Dma, 0, 0, output);
+	}
+	else {
+		FileOut(std::format("INIT DMA; {}", output));
+	}
 }
 
 void Log::Error(const auto& output)
@@ -87,6 +152,7 @@ void Log::Fatal(const auto& output, std::source_location loc)
 void Log::FileOut(const auto& output)
 {
 	if constexpr (enable_file_logging) {
+		std::scoped_lock lock{ file_log_mutex };
 		if (!file_log.is_open()) {
 			return;
 		}
@@ -114,37 +180,89 @@ void Log::Info(const auto& output)
 bool Log::Init()
 {
 	if constexpr (enable_file_logging) {
-		file_log.open(log_path.data());
-		return file_log.is_open();
+		if constexpr (trace_to_binary_file) {
+			if (!Trace::Open(trace_path)) {
+				return false;
+			}
+		}
+		/* The file is otherwise opened when a category is first switched on */
+		if (log_cpu_instructions || log_rsp_instructions || std::ranges::find(enabled_categories, true) != enabled_categories.end()) {
+			return OpenFile();
+		}
+	}
+	return true;
+}
+
+void Log::IoRead(std::string_view loc, std::string_view reg, std::integral auto value)
+{
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::IoRead, 0, u64(MakeUnsigned(value)), loc, reg);
 	}
 	else {
-		return true;
+		FileOut(std::format("{} IO: {} => ${:08X}", loc, reg, MakeUnsigned(value)));
 	}
 }
 
-void Log::IoRead(std::string_view loc, std::string_view reg, std::integral auto value)
+bool Log::IsEnabled(Category category)
 {
-	FileOut(std::format("{} IO: {} => ${:08X}", loc, reg, MakeUnsigned(value)));
+	return enabled_categories[std::to_underlying(category)];
 }
 
 void Log::IoWrite(std::string_view loc, std::string_view reg, std::integral auto value)
 {
-	FileOut(std::format("{} IO: {} <= ${:08X}", loc, reg, MakeUnsigned(value)));
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::IoWrite, 0, u64(MakeUnsigned(value)), loc, reg);
+	}
+	else {
+		FileOut(std::format("{} IO: {} <= ${:08X}", loc, reg, MakeUnsigned(value)));
+	}
+}
+
+bool Log::OpenFile()
+{
+	std::scoped_lock lock{ file_log_mutex };
+	if (!file_log.is_open()) {
+		file_log.open(log_path.data());
+	}
+	return file_log.is_open();
 }
 
-void Log::RspInstruction(u32 pc, const auto& instr_output)
+void Log::RspInstruction(u32 pc, const auto& instr_output, u32 instr_code)
 {
-	FileOut(std::format("RSP; ${:03X}  {}", pc, instr_output));
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::RspInstruction, pc, instr_code, instr_output);
+	}
+	else {
+		FileOut(std::format("RSP; ${:03X}  {}", pc, instr_output));
+	}
 }
 
 void Log::RspRead(u32 dmem_addr, std::integral auto value)
 {
-	FileOut(std::format("RSP READ; ${:0X} from DMEM ${:03X}", MakeUnsigned(value), dmem_addr));
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::RspRead, dmem_addr, u64(MakeUnsigned(value)), {});
+	}
+	else {
+		FileOut(std::format("RSP READ; ${:0X} from DMEM ${:03X}", MakeUnsigned(value), dmem_addr));
+	}
 }
 
 void Log::RspWrite(u32 dmem_addr, std::integral auto value)
 {
-	FileOut(std::format("RSP WRITE; ${:0X} to DMEM ${:03X}", MakeUnsigned(value), dmem_addr));
+	if constexpr (trace_to_binary_file) {
+		Trace::Write(Trace::Event::RspWrite, dmem_addr, u64(MakeUnsigned(value)), {});
+	}
+	else {
+		FileOut(std::format("RSP WRITE; ${:0X} to DMEM ${:03X}", MakeUnsigned(value), dmem_addr));
+	}
+}
+
+void Log::SetEnabled(Category category, bool enabled)
+{
+	enabled_categories[std::to_underlying(category)] = enabled;
+	if (enable_file_logging && enabled && !OpenFile()) {
+		ConsoleOut(std::format("[ERROR] Failed to open log file {}", log_path));
+	}
 }
 
 void Log::Warning(const auto& output)
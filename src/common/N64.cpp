@@ -3,9 +3,13 @@ module N64;
 import AI;
 import BuildOptions;
 import Cart;
+import FrameTiming;
+import Log;
+import Memory;
 import MI;
 import PI;
 import PIF;
+import Profiler;
 import RDP;
 import RDRAM;
 import RI;
@@ -18,8 +22,10 @@ import VR4300;
 
 namespace N64
 {
-	bool Init()
+	bool Init(bool headless)
 	{
+		is_headless = headless;
+
 		AI::Initialize();
 		MI::Initialize();
 		PI::Initialize();
@@ -31,6 +37,7 @@ namespace N64
 		VR4300::PowerOn();
 		RSP::PowerOn();
 		RDP::Initialize();
+		SetActiveIoFunctions();
 
 		Scheduler::Initialize(); /* init last */
 
@@ -42,10 +49,34 @@ namespace N64
 		return PIF::LoadIPL12(path);
 	}
 
+	bool IsAudioOutputEnabled()
+	{
+		return !is_headless && audio_output_enabled;
+	}
+
+	bool IsHeadless()
+	{
+		return is_headless;
+	}
+
+	bool IsVideoOutputEnabled()
+	{
+		return video_output_enabled;
+	}
+
 	bool LoadGame(std::filesystem::path const& path)
 	{
 		if (Cart::LoadRom(path)) {
 			game_loaded = true;
+			if constexpr (profile_guest) {
+				Profiler::Reset();
+			}
+			if constexpr (time_subsystems) {
+				FrameTiming::Reset();
+			}
+			if constexpr (persist_recompiled_blocks) {
+				VR4300::Recompiler::LoadBlockCache(Cart::GetRomHash(), output_file_suffix);
+			}
 		}
 		else {
 			game_loaded = false;
@@ -74,11 +105,39 @@ namespace N64
 		PIF::OnJoystickMovement(control, axis_value);
 	}
 
+	std::string OutputFilePath(std::string_view path)
+	{
+		/* Machines that run side by side (batch runner workers, fan-out children) would otherwise write the
+		   same files when stopped. The suffix goes before the extension: n64.folded => n64.rom3.folded */
+		if (output_file_suffix.empty()) {
+			return std::string(path);
+		}
+		std::filesystem::path suffixed_path = path;
+		suffixed_path.replace_extension(std::format(".{}{}", output_file_suffix, suffixed_path.extension().string()));
+		return suffixed_path.string();
+	}
+
 	void Pause()
 	{
 		// TODO
 	}
 
+	bool RecordInputMovie(std::filesystem::path const& path)
+	{
+		return PIF::RecordInputMovie(path);
+	}
+
+	bool ReplayInputMovie(std::filesystem::path const& path)
+	{
+		return PIF::ReplayInputMovie(path);
+	}
+
+	void RestoreSnapshot(std::vector<u8> const& snapshot)
+	{
+		Serializer serializer{ snapshot };
+		StreamState(serializer);
+	}
+
 	void Reset()
 	{
 		// TODO
@@ -89,15 +148,53 @@ namespace N64
 		 // TODO
 	}
 
-	void Run()
+	void Run(u64 cpu_cycles_to_run)
 	{
 		if (!running) {
 			Reset();
 			bool hle_pif = !bios_loaded || skip_boot_rom;
 			VR4300::InitRun(hle_pif);
+			Scheduler::Initialize();
 			running = true;
 		}
-		Scheduler::Run();
+		if (run_ahead_frames == 0) {
+			Scheduler::Run(cpu_cycles_to_run);
+		}
+		else {
+			RunWithRunAhead(cpu_cycles_to_run);
+		}
+	}
+
+	void RunWithRunAhead(u64 cpu_cycles_to_run)
+	{
+		/* Each iteration emulates one frame for real, with audio but without video, and takes a snapshot. It then
+		   emulates 'run_ahead_frames' frames more with the current input and without audio, presents the last one,
+		   and rewinds to the snapshot. Reactions to input that the game delays internally are thus seen earlier.
+		   A frame runs up to the end of the current VI field, so that the presented frame is a complete field. */
+		auto CyclesUntilFieldEnd = [] {
+			s64 cycles = Scheduler::GetCyclesUntilEvent(Scheduler::EventType::VINewField);
+			return cycles > 0 ? u64(cycles) : u64(cpu_cycles_per_frame); /* the VI has not scheduled a field */
+		};
+		while (running && cpu_cycles_to_run > 0) {
+			u64 cycles = std::min(cpu_cycles_to_run, CyclesUntilFieldEnd());
+			cpu_cycles_to_run -= cycles;
+			video_output_enabled = false;
+			Scheduler::Run(cycles);
+			if (!running) {
+				break;
+			}
+			TakeSnapshot(run_ahead_snapshot);
+			audio_output_enabled = false;
+			PIF::SetSpeculative(true);
+			for (uint i = 0; i < run_ahead_frames && running; ++i) {
+				video_output_enabled = i == run_ahead_frames - 1;
+				Scheduler::Run(CyclesUntilFieldEnd());
+			}
+			PIF::SetSpeculative(false);
+			RestoreSnapshot(run_ahead_snapshot);
+			audio_output_enabled = true;
+		}
+		video_output_enabled = true;
 	}
 
 	bool SaveState()
@@ -105,14 +202,93 @@ namespace N64
 		return true; // TODO
 	}
 
+	void SetActiveIoFunctions()
+	{
+		Memory::SetActiveIoFunctions();
+		RSP::SetActiveIoFunctions();
+	}
+
+	void SetInputLatchCallback(InputLatchCallback callback)
+	{
+		PIF::SetInputLatchCallback(callback);
+	}
+
+	void SetLogCategoryEnabled(Log::Category category, bool enabled)
+	{
+		Log::SetEnabled(category, enabled);
+		SetActiveIoFunctions();
+	}
+
+	void SetOutputFileSuffix(std::string_view suffix)
+	{
+		output_file_suffix = suffix;
+	}
+
+	void SetRunAheadFrames(uint frames)
+	{
+		run_ahead_frames = frames;
+	}
+
 	void Stop()
 	{
 		Scheduler::Stop();
 		running = false;
+		if constexpr (persist_recompiled_blocks) {
+			VR4300::Recompiler::SaveBlockCache(output_file_suffix);
+		}
+		if constexpr (profile_guest) {
+			std::string path = OutputFilePath(profile_path);
+			if (!Profiler::WriteCollapsedStacks(path)) {
+				UserMessage::Error(std::format("Failed to write profile to {}", path));
+			}
+		}
+		if constexpr (instruction_histograms) {
+			std::string path = OutputFilePath(instruction_histogram_path);
+			std::ofstream ofs{ path };
+			ofs << "cpu,class,instruction,count\n";
+			VR4300::WriteInstructionHistograms(ofs);
+			RSP::WriteInstructionHistograms(ofs);
+			if (!ofs) {
+				UserMessage::Error(std::format("Failed to write instruction histograms to {}", path));
+			}
+		}
+	}
+
+	void StopInputMovie()
+	{
+		PIF::StopInputMovie();
+	}
+
+	void StreamState(Serializer& serializer)
+	{
+		/* Let the RDP implementation finish writing to RDRAM before it is copied or overwritten */
+		if (RDP::implementation) {
+			RDP::implementation->OnFullSync();
+		}
+		AI::StreamState(serializer);
+		Cart::StreamState(serializer);
+		MI::StreamState(serializer);
+		PI::StreamState(serializer);
+		PIF::StreamState(serializer);
+		RDP::StreamState(serializer);
+		RDRAM::StreamState(serializer);
+		RSP::StreamState(serializer);
+		Scheduler::StreamState(serializer);
+		SI::StreamState(serializer);
+		VI::StreamState(serializer);
+		VR4300::StreamState(serializer);
+	}
+
+	void TakeSnapshot(std::vector<u8>& snapshot)
+	{
+		Serializer serializer{ snapshot };
+		StreamState(serializer);
 	}
 
 	void UpdateScreen()
 	{
-		RDP::implementation->UpdateScreen();
+		if (RDP::implementation) {
+			RDP::implementation->UpdateScreen();
+		}
 	}
 }
\ No newline at end of file
@@ -1,13 +1,24 @@
 export module N64;
 
+import Log;
 import RDP;
+import Serializer;
 import Util;
 
+import <algorithm>;
 import <filesystem>;
+import <format>;
+import <fstream>;
 import <iostream>;
+import <limits>;
 import <optional>;
 import <string>;
+import <string_view>;
+import <vector>;
 
+/* All emulator core state (CPU, RCP, memory, scheduler, ...) is thread_local: each thread that calls Init
+   owns one machine, and several threads can run machines side by side. The machine running on the GUI thread
+   is the only one connected to audio and video output; machines created with 'headless' run without them. */
 namespace N64
 {
 	export
@@ -18,19 +29,33 @@ namespace N64
 			CX, CY /* alternative to CUp, CDown etc for controlling C buttons using a joystick */
 		};
 
-		bool Init();
+		using InputLatchCallback = void(*)();
+
+		bool Init(bool headless = false);
 		bool LoadBios(std::filesystem::path const& bios_path);
+		bool IsAudioOutputEnabled();
+		bool IsHeadless();
+		bool IsVideoOutputEnabled();
 		bool LoadGame(std::filesystem::path const& game_path);
 		bool LoadState();
 		void OnButtonDown(Control control);
 		void OnButtonUp(Control control);
 		void OnJoystickMovement(Control control, s16 axis_value);
 		void Pause();
+		bool RecordInputMovie(std::filesystem::path const& movie_path);
+		bool ReplayInputMovie(std::filesystem::path const& movie_path);
+		void RestoreSnapshot(std::vector<u8> const& snapshot);
 		void Reset();
 		void Resume();
-		void Run();
+		void Run(u64 cpu_cycles_to_run = std::numeric_limits<u64>::max()); /* resumes where the last call left off */
 		bool SaveState();
+		void SetInputLatchCallback(InputLatchCallback callback); /* invoked when the game polls the controller */
+		void SetLogCategoryEnabled(Log::Category category, bool enabled); /* takes effect immediately, also mid-run */
+		void SetOutputFileSuffix(std::string_view suffix); /* see OutputFilePath */
+		void SetRunAheadFrames(uint frames); /* 0 disables run-ahead */
 		void Stop();
+		void StopInputMovie();
+		void TakeSnapshot(std::vector<u8>& snapshot); /* in-memory; see Serializer */
 		void UpdateScreen();
 
 		constexpr uint cpu_cycles_per_second = 93'750'000;
@@ -39,7 +64,20 @@ namespace N64
 		constexpr uint rsp_cycles_per_frame = rsp_cycles_per_second / 60; /* 1,041,675 */
 	}
 
-	bool bios_loaded;
-	bool game_loaded;
-	bool running;
+	std::string OutputFilePath(std::string_view path);
+	void RunWithRunAhead(u64 cpu_cycles_to_run);
+	void SetActiveIoFunctions();
+	void StreamState(Serializer& serializer);
+
+	thread_local bool audio_output_enabled = true;
+	thread_local bool bios_loaded;
+	thread_local bool game_loaded;
+	thread_local bool is_headless;
+	thread_local bool running;
+	thread_local bool video_output_enabled = true;
+
+	thread_local std::string output_file_suffix;
+	thread_local uint run_ahead_frames;
+
+	thread_local std::vector<u8> run_ahead_snapshot;
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+module Profiler;
+
+namespace Profiler
+{
+	void OnCpuCall(u32 target_addr, u32 return_addr)
+	{
+		if (cpu_call_stack.size() < max_stack_depth) {
+			cpu_call_stack.emplace_back(target_addr, return_addr);
+		}
+		else {
+			++num_untracked_calls;
+		}
+	}
+
+
+	void OnCpuReturn(u32 target_addr)
+	{
+		if (num_untracked_calls > 0) {
+			--num_untracked_calls;
+			return;
+		}
+		/* Unwind to the frame that is returned from. Code that switches stacks (e.g. the OS scheduler switching
+		   threads) returns to addresses that were never called from; the stack is left as it is then. */
+		for (size_t i = cpu_call_stack.size(); i > 0; --i) {
+			if (cpu_call_stack[i - 1].return_addr == target_addr) {
+				cpu_call_stack.resize(i - 1);
+				return;
+			}
+		}
+	}
+
+
+	void OnRspStart(u64 imem_hash)
+	{
+		rsp_task_hash = imem_hash;
+	}
+
+
+	void Reset()
+	{
+		cpu_call_stack.clear();
+		num_untracked_calls = 0;
+		cpu_samples.clear();
+		rsp_samples.clear();
+		rsp_task_hash = 0;
+		cycles_until_sample = sample_interval;
+	}
+
+
+	void Tick(u64 cpu_cycles, bool rsp_running)
+	{
+		if (cpu_cycles < cycles_until_sample) {
+			cycles_until_sample -= cpu_cycles;
+			return;
+		}
+		/* A step can span several intervals, e.g. when the scheduler has skipped an idle loop. Each of them counts
+		   as a sample of the same state, and the cycles left over carry into the next interval. */
+		u64 cycles_past_sample = cpu_cycles - cycles_until_sample;
+		u64 num_samples = 1 + cycles_past_sample / sample_interval;
+		cycles_until_sample = sample_interval - cycles_past_sample % sample_interval;
+		std::vector<u32> stack(cpu_call_stack.size());
+		for (size_t i = 0; i < cpu_call_stack.size(); ++i) {
+			stack[i] = cpu_call_stack[i].function_addr;
+		}
+		cpu_samples[std::move(stack)] += num_samples;
+		if (rsp_running) {
+			rsp_samples[rsp_task_hash] += num_samples;
+		}
+	}
+
+
+	bool WriteCollapsedStacks(std::filesystem::path const& path)
+	{
+		std::ofstream ofs{ path };
+		if (!ofs) {
+			return false;
+		}
+		for (auto const& [stack, num_samples] : cpu_samples) {
+			ofs << "vr4300";
+			if (stack.empty()) {
+				ofs << ";entry";
+			}
+			for (u32 function_addr : stack) {
+				ofs << std::format(";func_{:08X}", function_addr);
+			}
+			ofs << ' ' << num_samples << '\n';
+		}
+		for (auto const& [imem_hash, num_samples] : rsp_samples) {
+			ofs << std::format("rsp;ucode_{:016x} {}\n", imem_hash, num_samples);
+		}
+		return ofs.good();
+	}
+}
@@ -0,0 +1,44 @@
+export module Profiler;
+
+import Util;
+
+import <filesystem>;
+import <format>;
+import <fstream>;
+import <map>;
+import <unordered_map>;
+import <vector>;
+
+/* Guest-level sampling profiler, enabled with 'profile_guest' in BuildOptions. Every 'sample_interval' cpu cycles,
+   the scheduler takes a sample of what the VR4300 and the RSP are running. The VR4300 is attributed to a call
+   stack of guest functions, which is maintained by pushing on JAL/JALR and popping on JR ra; functions are named
+   after their entry address. The RSP, while running, is attributed to the microcode it was started with, which is
+   identified by a hash of IMEM. The samples are written as collapsed stacks, the input format of flamegraph.pl:
+   one line per distinct stack, e.g. 'vr4300;func_80000400;func_80246DF8 123'. */
+namespace Profiler
+{
+	export
+	{
+		void OnCpuCall(u32 target_addr, u32 return_addr);
+		void OnCpuReturn(u32 target_addr);
+		void OnRspStart(u64 imem_hash);
+		void Reset();
+		void Tick(u64 cpu_cycles, bool rsp_running);
+		bool WriteCollapsedStacks(std::filesystem::path const& path);
+	}
+
+	struct StackFrame {
+		u32 function_addr;
+		u32 return_addr;
+	};
+
+	constexpr u64 sample_interval = 10'000;
+	constexpr size_t max_stack_depth = 128; /* calls beyond this are not tracked */
+
+	thread_local std::vector<StackFrame> cpu_call_stack;
+	thread_local size_t num_untracked_calls; /* made while the stack was at its maximum depth */
+	thread_local std::map<std::vector<u32>, u64> cpu_samples; /* function addresses, outermost first => #samples */
+	thread_local std::unordered_map<u64, u64> rsp_samples; /* imem hash => #samples */
+	thread_local u64 rsp_task_hash;
+	thread_local u64 cycles_until_sample;
+}
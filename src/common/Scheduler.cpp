@@ -1,5 +1,9 @@
 module Scheduler;
 
+import Bench;
+import BuildOptions;
+import FrameTiming;
+import Profiler;
 import RSP;
 import VI;
 import VR4300;
@@ -40,6 +44,7 @@ namespace Scheduler
 
 	void CheckEvents(s64 cpu_cycle_step)
 	{
+		global_time += cpu_cycle_step;
 		for (auto it = events.begin(); it != events.end(); ) {
 			it->cpu_cycles_until_fire -= cpu_cycle_step;
 			if (it->cpu_cycles_until_fire <= 0) {
@@ -56,9 +61,29 @@ namespace Scheduler
 	}
 
 
+	s64 GetCyclesUntilEvent(EventType event_type)
+	{
+		/* Returns 0 if the event is not enqueued */
+		for (Event const& event : events) {
+			if (event.event_type == event_type) {
+				return std::max(s64(0), event.cpu_cycles_until_fire - s64(VR4300::GetElapsedCycles()));
+			}
+		}
+		return 0;
+	}
+
+
+	u64 GetGlobalTime()
+	{
+		return global_time + VR4300::GetElapsedCycles();
+	}
+
+
 	void Initialize()
 	{
 		quit = false;
+		global_time = 0;
+		cpu_cycle_overrun = rsp_cycle_overrun = 0;
 		events.clear();
 		events.reserve(16);
 		VR4300::AddInitialEvents();
@@ -66,6 +91,13 @@ namespace Scheduler
 	}
 
 
+	template<EventType event_type, s64 period>
+	void RearmBenchEvent()
+	{
+		AddEvent(event_type, period, RearmBenchEvent<event_type, period>);
+	}
+
+
 	void RemoveEvent(EventType event_type)
 	{
 		for (auto it = events.begin(); it != events.end(); ++it) {
@@ -77,18 +109,60 @@ namespace Scheduler
 	}
 
 
-	void Run()
+	void Run(u64 cpu_cycles_to_run)
 	{
-		Initialize();
-
-		s64 cpu_cycle_overrun = 0, rsp_cycle_overrun = 0;
-		while (!quit) {
+		/* Runs until Stop is called or the given number of cycles has elapsed, whichever comes first. The machine
+		   can be resumed with another call; Initialize is not called here. */
+		u64 end_time = cpu_cycles_to_run > std::numeric_limits<u64>::max() - global_time
+			? std::numeric_limits<u64>::max()
+			: global_time + cpu_cycles_to_run;
+		while (!quit && global_time < end_time) {
 			s64 cpu_step_dur = cpu_cycles_per_update - cpu_cycle_overrun;
 			s64 rsp_step_dur = cpu_cycles_per_update - rsp_cycle_overrun;
+			FrameTiming::Enter(FrameTiming::Unit::Cpu);
 			cpu_cycle_overrun = VR4300::Run(cpu_step_dur);
+			bool rsp_was_halted = RSP::IsHalted();
+			FrameTiming::Enter(FrameTiming::Unit::Rsp);
 			rsp_cycle_overrun = RSP::Run(rsp_step_dur);
+			FrameTiming::Enter(FrameTiming::Unit::Events);
+			if constexpr (skip_idle_loops) {
+				/* If the CPU is spinning in an idle loop and the RSP has been halted throughout the step,
+				   nothing can happen before the next event fires. Fast-forward to it. */
+				if (VR4300::IsIdle() && rsp_was_halted && !events.empty()
+					&& events.front().cpu_cycles_until_fire > cpu_step_dur) {
+					VR4300::SkipIdleCycles(events.front().cpu_cycles_until_fire - cpu_step_dur);
+					cpu_step_dur = events.front().cpu_cycles_until_fire;
+				}
+			}
+			if constexpr (profile_guest) {
+				Profiler::Tick(cpu_step_dur, !rsp_was_halted);
+			}
 			CheckEvents(cpu_step_dur);
 		}
+		FrameTiming::Enter(FrameTiming::Unit::Other);
+	}
+
+
+	void RunBenchmarks()
+	{
+		/* A queue resembling that of a running game: periodic events re-add themselves when they fire */
+		using enum EventType;
+		events.clear();
+		RearmBenchEvent<VINewField, 1'562'500>();
+		RearmBenchEvent<CountCompareMatch, 3'000'000>();
+		RearmBenchEvent<AiDmaFinish, 150'000>();
+		RearmBenchEvent<PiDmaFinish, 20'000>();
+		RearmBenchEvent<SiDmaFinish, 40'000>();
+		RearmBenchEvent<SpDmaFinish, 3'000>();
+		Bench::Measure("Scheduler CheckEvents (one step)", [](u64) {
+			CheckEvents(cpu_cycles_per_update);
+		});
+		Bench::Measure("Scheduler AddEvent + RemoveEvent", [](u64 i) {
+			AddEvent(VIInterrupt, 10'000 + s64(i & 0xFFFF), [] {});
+			RemoveEvent(VIInterrupt);
+		});
+		events.clear();
+		global_time = 0;
 	}
 
 
@@ -96,4 +170,10 @@ namespace Scheduler
 	{
 		quit = true;
 	}
+
+
+	void StreamState(Serializer& serializer)
+	{
+		serializer.Stream(global_time, cpu_cycle_overrun, rsp_cycle_overrun, events);
+	}
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 export module Scheduler;
 
+import Serializer;
 import Util;
 
+import <algorithm>;
+import <limits>;
 import <vector>;
 
 namespace Scheduler
@@ -11,20 +14,25 @@ namespace Scheduler
 		using EventCallback = void(*)();
 
 		enum class EventType {
-			AudioSample,
+			AiDmaFinish,
 			CountCompareMatch,
 			PiDmaFinish,
 			SiDmaFinish,
 			SpDmaFinish,
-			VINewHalfline
+			VIInterrupt,
+			VINewField
 		};
 
 		void AddEvent(EventType event, s64 cpu_cycles_until_fire, EventCallback callback);
 		void ChangeEventTime(EventType event, s64 cpu_cycles_until_fire);
+		s64 GetCyclesUntilEvent(EventType event);
+		u64 GetGlobalTime();
 		void Initialize();
 		void RemoveEvent(EventType event);
-		void Run();
+		void Run(u64 cpu_cycles_to_run = std::numeric_limits<u64>::max());
+		void RunBenchmarks(); /* see Bench; clears the event queue */
 		void Stop();
+		void StreamState(Serializer& serializer);
 	}
 
 	struct Event {
@@ -34,13 +42,18 @@ namespace Scheduler
 	};
 
 	void CheckEvents(s64 cpu_cycle_step);
+	template<EventType, s64 period> void RearmBenchEvent();
 
 	constexpr s64 cpu_cycles_per_update = 90;
 	constexpr s64 rsp_cycles_per_update = 2 * cpu_cycles_per_update / 3;
 	static_assert(2 * cpu_cycles_per_update == 3 * rsp_cycles_per_update,
 		"CPU cycles per update must be divisible by 3.");
 
-	bool quit;
+	thread_local bool quit;
 
-	std::vector<Event> events; /* sorted after when they will occur */
+	thread_local s64 cpu_cycle_overrun, rsp_cycle_overrun; /* kept across calls to Run so that resuming is seamless */
+
+	thread_local u64 global_time; /* CPU cycles elapsed since Initialize, up until the start of the current step */
+
+	thread_local std::vector<Event> events; /* sorted after when they will occur */
 }
\ No newline at end of file
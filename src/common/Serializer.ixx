@@ -0,0 +1,65 @@
+export module Serializer;
+
+import Util;
+
+import <cstring>;
+import <type_traits>;
+import <vector>;
+
+/* In-memory snapshots of the machine state. Every module that owns state has a 'StreamState' function which,
+   depending on the mode of the serializer, either appends its state to the snapshot or reads it back; the order
+   in which values are streamed is the layout of the snapshot, so the two directions cannot go out of sync.
+   Values are copied bytewise, function pointers included. A snapshot is therefore only valid within the process
+   (and on the thread) that took it; it is not a save file format. */
+export class Serializer
+{
+public:
+	/* Saves to 'snapshot'. Its capacity is kept, so that taking repeated snapshots does not reallocate. */
+	explicit Serializer(std::vector<u8>& snapshot) : out(&snapshot), in(nullptr), pos(0)
+	{
+		snapshot.clear();
+	}
+
+	/* Loads from 'snapshot' */
+	explicit Serializer(std::vector<u8> const& snapshot) : out(nullptr), in(snapshot.data()), pos(0) {}
+
+	template<typename... T>
+	void Stream(T&... values)
+	{
+		(StreamValue(values), ...);
+	}
+
+	void StreamBytes(void* data, size_t size)
+	{
+		if (out) {
+			u8 const* bytes = static_cast<u8 const*>(data);
+			out->insert(out->end(), bytes, bytes + size);
+		}
+		else {
+			std::memcpy(data, in + pos, size);
+		}
+		pos += size;
+	}
+
+private:
+	template<typename T> requires std::is_trivially_copyable_v<T>
+	void StreamValue(T& value)
+	{
+		StreamBytes(&value, sizeof(T));
+	}
+
+	template<typename T> requires std::is_trivially_copyable_v<T>
+	void StreamValue(std::vector<T>& vec)
+	{
+		size_t size = vec.size();
+		StreamValue(size);
+		if (in) {
+			vec.resize(size);
+		}
+		StreamBytes(vec.data(), size * sizeof(T));
+	}
+
+	std::vector<u8>* out;
+	u8 const* in;
+	size_t pos;
+};
@@ -0,0 +1,184 @@
+module;
+
+#ifdef _WIN64
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+module Trace;
+
+namespace Trace
+{
+	int Decode(std::span<char* const> args)
+	{
+		if (args.size() != 1) {
+			std::cerr << "Usage: --decode-trace <file>\n";
+			return 2;
+		}
+		std::ifstream ifs{ args[0], std::ios::binary };
+		Header file_header;
+		if (!ifs.read(reinterpret_cast<char*>(&file_header), sizeof(file_header))
+			|| file_header.magic != magic || file_header.version != version) {
+			std::cerr << std::format("[error] {} is not a trace file\n", args[0]);
+			return 2;
+		}
+		std::vector<Record> file_records(file_header.capacity);
+		ifs.read(reinterpret_cast<char*>(file_records.data()), file_header.capacity * sizeof(Record));
+		file_records.resize(ifs.gcount() / sizeof(Record));
+		std::erase_if(file_records, [](Record const& record) { return record.sequence == 0; });
+		std::ranges::sort(file_records, {}, &Record::sequence);
+		for (Record const& record : file_records) {
+			PrintRecord(std::cout, record);
+		}
+		return 0;
+	}
+
+
+	bool Map(std::filesystem::path const& path, size_t size)
+	{
+#ifdef _WIN64
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+			CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, DWORD(u64(size) >> 32), DWORD(size), nullptr);
+		CloseHandle(file);
+		if (!mapping) {
+			return false;
+		}
+		void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+		CloseHandle(mapping);
+		if (!view) {
+			return false;
+		}
+#else
+		int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			return false;
+		}
+		if (ftruncate(fd, off_t(size)) != 0) {
+			close(fd);
+			return false;
+		}
+		void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (view == MAP_FAILED) {
+			return false;
+		}
+#endif
+		header = static_cast<Header*>(view);
+		records = reinterpret_cast<Record*>(header + 1);
+		mapping_size = size;
+		return true;
+	}
+
+
+	bool Open(std::filesystem::path const& path)
+	{
+		if (header) {
+			return true;
+		}
+		if (!Map(path, sizeof(Header) + trace_capacity * sizeof(Record))) {
+			return false;
+		}
+		/* The file is zero-filled, so all records are marked as unused */
+		header->magic = magic;
+		header->version = version;
+		header->capacity = trace_capacity;
+		flusher = std::jthread(RunFlusher);
+		return true;
+	}
+
+
+	void PrintRecord(std::ostream& os, Record const& record)
+	{
+		std::string_view text{ record.text.data(), strnlen(record.text.data(), record.text.size()) };
+		switch (record.event) {
+		case Event::CpuInstruction:
+			os << std::format("CPU; ${:08X}  {} ({:08X})\n", record.addr, text, record.value);
+			break;
+		case Event::CpuException:
+			os << std::format("EXCEPTION; {}\n", text);
+			break;
+		case Event::CpuRead:
+			os << std::format("CPU READ; ${:0X} from ${:08X}\n", record.value, record.addr);
+			break;
+		case Event::CpuWrite:
+			os << std::format("CPU WRITE; ${:0X} to ${:08X}\n", record.value, record.addr);
+			break;
+		case Event::Dma:
+			os << std::format("INIT DMA; {}\n", text);
+			break;
+		case Event::IoRead:
+		case Event::IoWrite: {
+			size_t space = text.find(' ');
+			os << std::format("{} IO: {} {} ${:08X}\n", text.substr(0, space),
+				space == text.npos ? std::string_view{} : text.substr(space + 1),
+				record.event == Event::IoRead ? "=>" : "<=", record.value);
+			break;
+		}
+		case Event::RspInstruction:
+			os << std::format("RSP; ${:03X}  {} ({:08X})\n", record.addr, text, record.value);
+			break;
+		case Event::RspRead:
+			os << std::format("RSP READ; ${:0X} from DMEM ${:03X}\n", record.value, record.addr);
+			break;
+		case Event::RspWrite:
+			os << std::format("RSP WRITE; ${:0X} to DMEM ${:03X}\n", record.value, record.addr);
+			break;
+		default:
+			os << std::format("UNKNOWN EVENT {}\n", u32(record.event));
+			break;
+		}
+	}
+
+
+	void RunFlusher(std::stop_token stop_token)
+	{
+		std::unique_lock lock{ flusher_mutex };
+		while (!stop_token.stop_requested()) {
+			flusher_cv.wait_for(lock, stop_token, flush_interval, [] { return false; });
+			SyncMapping();
+		}
+	}
+
+
+	void SyncMapping()
+	{
+#ifdef _WIN64
+		FlushViewOfFile(header, mapping_size);
+#else
+		msync(header, mapping_size, MS_ASYNC);
+#endif
+	}
+
+
+	void Write(Event event, u32 addr, u64 value, std::string_view text, std::string_view text2)
+	{
+		if (!header) {
+			return;
+		}
+		u64 sequence = std::atomic_ref(header->next_sequence).fetch_add(1, std::memory_order_relaxed) + 1;
+		Record& record = records[sequence % trace_capacity];
+		std::atomic_ref(record.sequence).store(0, std::memory_order_relaxed);
+		record.value = value;
+		record.addr = addr;
+		record.event = event;
+		size_t len = std::min(text.size(), record.text.size());
+		std::memcpy(record.text.data(), text.data(), len);
+		if (!text2.empty() && len < record.text.size()) {
+			record.text[len++] = ' ';
+			size_t len2 = std::min(text2.size(), record.text.size() - len);
+			std::memcpy(record.text.data() + len, text2.data(), len2);
+			len += len2;
+		}
+		if (len < record.text.size()) {
+			record.text[len] = '\0';
+		}
+		std::atomic_ref(record.sequence).store(sequence, std::memory_order_release);
+	}
+}
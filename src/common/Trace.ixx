@@ -0,0 +1,78 @@
+export module Trace;
+
+import Util;
+
+import <algorithm>;
+import <array>;
+import <atomic>;
+import <chrono>;
+import <condition_variable>;
+import <cstring>;
+import <filesystem>;
+import <format>;
+import <fstream>;
+import <iostream>;
+import <mutex>;
+import <span>;
+import <stop_token>;
+import <string_view>;
+import <thread>;
+import <vector>;
+
+/* Binary trace, used as the backend of the instruction, IO, DMA and exception logs when 'trace_to_binary_file' is
+   set in BuildOptions. Every event is one fixed-size record, copied into a ring of records in a memory-mapped file;
+   nothing is formatted while emulating. Once the ring is full, the oldest records are overwritten, so the file
+   always holds the most recent 'trace_capacity' events, which makes it cheap enough to leave on while waiting for
+   a rare bug. A background thread periodically asks the OS to write the mapped pages back, so that the trace
+   survives a crash of the process. Records are claimed with an atomic counter, so machines on several threads
+   can share the trace. '--decode-trace <file>' prints a trace as text, in the format of the text log. */
+namespace Trace
+{
+	export
+	{
+		enum class Event : u32 {
+			CpuInstruction, CpuException, CpuRead, CpuWrite, Dma, IoRead, IoWrite, RspInstruction, RspRead, RspWrite
+		};
+
+		int Decode(std::span<char* const> args); /* returns the process exit code */
+		bool Open(std::filesystem::path const& path);
+		/* 'text2', if given, is appended to 'text' with a space in between */
+		void Write(Event event, u32 addr, u64 value, std::string_view text, std::string_view text2 = {});
+	}
+
+	struct Header {
+		std::array<char, 4> magic;
+		u32 version;
+		u64 capacity; /* in records */
+		u64 next_sequence; /* accessed atomically */
+		std::array<u64, 5> padding;
+	};
+
+	struct Record {
+		u64 sequence; /* starts at 1; 0 marks a slot that has not been written to. Written last. */
+		u64 value;
+		u32 addr;
+		Event event;
+		std::array<char, 72> text; /* not null-terminated if all of it is used */
+	};
+
+	static_assert(sizeof(Header) == 64);
+	static_assert(sizeof(Record) == 96);
+
+	bool Map(std::filesystem::path const& path, size_t size);
+	void PrintRecord(std::ostream& os, Record const& record);
+	void RunFlusher(std::stop_token stop_token);
+	void SyncMapping();
+
+	constexpr std::array<char, 4> magic = { 'N', '6', 'T', 'R' };
+	constexpr u32 version = 1;
+	constexpr u64 trace_capacity = 1 << 20;
+	constexpr auto flush_interval = std::chrono::seconds(1);
+
+	Header* header;
+	Record* records;
+	size_t mapping_size;
+	std::mutex flusher_mutex;
+	std::condition_variable_any flusher_cv;
+	std::jthread flusher; /* declared last, so that it is joined before the rest is destroyed */
+}
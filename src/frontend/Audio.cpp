@@ -2,8 +2,13 @@ module;
 
 #include "SDL.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 module Audio;
 
+import FrameTiming;
 import UserMessage;
 
 void Audio::OnDeviceAdded(SDL_Event event)
@@ -16,14 +21,46 @@ void Audio::OnDeviceRemoved(SDL_Event event)
 	// TODO
 }
 
+u32 Audio::ComputeStep()
+{
+	/* Dynamic rate control; consume slightly faster when above the target fill level, and slightly slower when below it. */
+	size_t fill = ring_write_pos.load(std::memory_order_acquire) - ring_read_pos.load(std::memory_order_relaxed);
+	f64 fill_deviation = std::clamp((f64(fill) - f64(target_fill)) / f64(target_fill), -1.0, 1.0);
+	f64 ratio = f64(guest_sample_rate.load(std::memory_order_relaxed)) / f64(host_sample_rate);
+	return u32(ratio * (1.0 + max_rate_deviation * fill_deviation) * (1 << resample_frac_bits));
+}
+
 void Audio::Disable()
 {
-	// TODO
+	if (audio_device_id != 0) {
+		SDL_PauseAudioDevice(audio_device_id, 1);
+	}
+	audio_enabled = false;
 }
 
 void Audio::Enable()
 {
-	// TODO
+	if (audio_device_id != 0) {
+		SDL_PauseAudioDevice(audio_device_id, 0);
+		audio_enabled = true;
+	}
+}
+
+uint Audio::GetInputFramesAvailable()
+{
+	return uint((ring_write_pos.load(std::memory_order_acquire) - ring_read_pos.load(std::memory_order_relaxed)) / bytes_per_frame);
+}
+
+bool Audio::HostHasSse41()
+{
+	/* The vectorized resampler uses pshufb (SSSE3), and pmulld and pmovsxwd (SSE4.1) */
+#ifdef _MSC_VER
+	int cpu_info[4];
+	__cpuid(cpu_info, 1);
+	return (cpu_info[2] & 1 << 9) && (cpu_info[2] & 1 << 19);
+#else
+	return __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1");
+#endif
 }
 
 bool Audio::Init()
@@ -37,25 +74,143 @@ bool Audio::Init()
 	static constexpr int default_num_output_channels = 2;
 	static constexpr int default_sample_buffer_size_per_channel = 512;
 
+	/* The guest's big-endian samples are byteswapped while being resampled, so the device gets the host's byte order. */
 	SDL_AudioSpec desired_spec = {
 		.freq = default_sample_rate,
-		.format = AUDIO_S16MSB,
+		.format = AUDIO_S16SYS,
 		.channels = default_num_output_channels,
-		.samples = default_sample_buffer_size_per_channel
+		.samples = default_sample_buffer_size_per_channel,
+		.callback = SdlAudioCallback
 	};
 
+	ring_read_pos = ring_write_pos = 0;
+	use_sse41 = HostHasSse41();
+	guest_sample_rate = default_sample_rate;
+	resample_pos = 0;
+	last_output_frame[0] = last_output_frame[1] = 0;
+
 	SDL_AudioSpec obtained_spec;
-	audio_device_id = SDL_OpenAudioDevice(nullptr, 0, &desired_spec, &obtained_spec, 0);
+	audio_device_id = SDL_OpenAudioDevice(nullptr, 0, &desired_spec, &obtained_spec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
 	if (audio_device_id == 0) {
 		UserMessage::Warning(std::format("Could not open an audio device; {}", SDL_GetError()));
 		return false;
 	}
-
-	//SetSampleRate(obtained_spec.freq);
-	//num_output_channels = obtained_spec.channels;
-	//sample_buffer_size_per_channel = obtained_spec.samples;
+	host_sample_rate = obtained_spec.freq;
 
 	SDL_PauseAudioDevice(audio_device_id, 0);
+	audio_enabled = true;
 
 	return true;
-}
\ No newline at end of file
+}
+
+void Audio::PushSamples(u8 const* samples, size_t num_bytes)
+{
+	/* Called from the emulation thread. Wait for the consumer if it is behind; this is what paces the emulation.
+	   If it still has not caught up after a while, the samples that do not fit are dropped. */
+	size_t write_pos = ring_write_pos.load(std::memory_order_relaxed);
+	if (audio_enabled) {
+		FrameTiming::Scope timing_scope{ FrameTiming::Unit::Wait };
+		for (uint ms_waited = 0; ms_waited < max_producer_wait_ms; ++ms_waited) {
+			if (write_pos - ring_read_pos.load(std::memory_order_acquire) <= max_fill) break;
+			SDL_Delay(1);
+		}
+	}
+	size_t read_pos = ring_read_pos.load(std::memory_order_acquire);
+	size_t num_bytes_free = ring_buffer_size - (write_pos - read_pos);
+	num_bytes = std::min(num_bytes, num_bytes_free) & ~(bytes_per_frame - 1);
+	size_t offset = write_pos & (ring_buffer_size - 1);
+	size_t num_bytes_until_wrap = std::min(num_bytes, ring_buffer_size - offset);
+	std::memcpy(ring_buffer.data() + offset, samples, num_bytes_until_wrap);
+	std::memcpy(ring_buffer.data(), samples + num_bytes_until_wrap, num_bytes - num_bytes_until_wrap);
+	ring_write_pos.store(write_pos + num_bytes, std::memory_order_release);
+}
+
+void Audio::Resample(s16* dst, uint num_output_frames, uint num_input_frames_available, u32 step)
+{
+	/* Linear interpolation from the guest rate to the host rate, byteswapping the big-endian input in the same pass.
+	   Precondition: input frames at (resample_pos >> resample_frac_bits) + 1 are available for every output frame. */
+	size_t read_frame = ring_read_pos.load(std::memory_order_relaxed) / bytes_per_frame;
+
+	auto LoadFrame = [&](u64 pos) {
+		u32 frame;
+		size_t offset = (read_frame + (pos >> resample_frac_bits)) * bytes_per_frame & (ring_buffer_size - 1);
+		std::memcpy(&frame, ring_buffer.data() + offset, bytes_per_frame);
+		return frame;
+	};
+	auto LoadNextFrame = [&](u64 pos) {
+		return LoadFrame(pos + (1 << resample_frac_bits));
+	};
+	/* Interpolation weights are reduced to 15 bits so that (s1 - s0) * weight fits in 32 bits. */
+	auto Weight = [&](u64 pos) {
+		return s32(pos >> (resample_frac_bits - 15) & 0x7FFF);
+	};
+
+	static const __m128i byteswap_16_mask = _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+
+	uint i = 0;
+	if (use_sse41) {
+		for (; i + 4 <= num_output_frames; i += 4) {
+			u64 pos[4] = { resample_pos, resample_pos + step, resample_pos + 2 * step, resample_pos + 3 * step };
+			__m128i s0 = _mm_set_epi32(LoadFrame(pos[3]), LoadFrame(pos[2]), LoadFrame(pos[1]), LoadFrame(pos[0]));
+			__m128i s1 = _mm_set_epi32(LoadNextFrame(pos[3]), LoadNextFrame(pos[2]), LoadNextFrame(pos[1]), LoadNextFrame(pos[0]));
+			s0 = _mm_shuffle_epi8(s0, byteswap_16_mask);
+			s1 = _mm_shuffle_epi8(s1, byteswap_16_mask);
+			/* Each frame is two samples (L, R); the same weight applies to both. */
+			__m128i weight_lo = _mm_set_epi32(Weight(pos[1]), Weight(pos[1]), Weight(pos[0]), Weight(pos[0]));
+			__m128i weight_hi = _mm_set_epi32(Weight(pos[3]), Weight(pos[3]), Weight(pos[2]), Weight(pos[2]));
+			auto Lerp = [](__m128i s0, __m128i s1, __m128i weight) {
+				__m128i diff = _mm_sub_epi32(s1, s0);
+				return _mm_add_epi32(s0, _mm_srai_epi32(_mm_mullo_epi32(diff, weight), 15));
+			};
+			__m128i out_lo = Lerp(_mm_cvtepi16_epi32(s0), _mm_cvtepi16_epi32(s1), weight_lo);
+			__m128i out_hi = Lerp(_mm_cvtepi16_epi32(_mm_srli_si128(s0, 8)), _mm_cvtepi16_epi32(_mm_srli_si128(s1, 8)), weight_hi);
+			_mm_storeu_si128((__m128i*)(dst + 2 * i), _mm_packs_epi32(out_lo, out_hi));
+			resample_pos += 4 * step;
+		}
+	}
+	for (; i < num_output_frames; ++i) {
+		u32 f0 = LoadFrame(resample_pos), f1 = LoadNextFrame(resample_pos);
+		s32 weight = Weight(resample_pos);
+		for (int ch = 0; ch < 2; ++ch) {
+			s32 s0 = s16(std::byteswap(u16(f0 >> (16 * ch))));
+			s32 s1 = s16(std::byteswap(u16(f1 >> (16 * ch))));
+			dst[2 * i + ch] = s16(s0 + ((s1 - s0) * weight >> 15));
+		}
+		resample_pos += step;
+	}
+	if (num_output_frames > 0) {
+		std::memcpy(last_output_frame, dst + 2 * (num_output_frames - 1), sizeof(last_output_frame));
+	}
+
+	/* Release the input frames that have been fully consumed */
+	size_t num_input_frames_consumed = std::min(size_t(resample_pos >> resample_frac_bits), size_t(num_input_frames_available));
+	resample_pos -= u64(num_input_frames_consumed) << resample_frac_bits;
+	ring_read_pos.store((read_frame + num_input_frames_consumed) * bytes_per_frame, std::memory_order_release);
+}
+
+void Audio::SdlAudioCallback(void* /* userdata */, u8* stream, int len)
+{
+	/* Called from the SDL audio thread. On underrun, the last output frame is held for the remainder of the stream. */
+	s16* dst = (s16*)stream;
+	uint num_output_frames = uint(len) / bytes_per_frame;
+	uint num_input_frames_available = GetInputFramesAvailable();
+	u32 step = std::max(1u, ComputeStep());
+	uint num_output_frames_possible = 0;
+	if (num_input_frames_available >= 2) {
+		/* The last output frame interpolates between input frames n and n + 1, where n = pos >> frac_bits. */
+		u64 last_pos = u64(num_input_frames_available - 2) << resample_frac_bits | ((1 << resample_frac_bits) - 1);
+		if (last_pos >= resample_pos) {
+			num_output_frames_possible = uint((last_pos - resample_pos) / step) + 1;
+		}
+	}
+	uint num_output_frames_resampled = std::min(num_output_frames, num_output_frames_possible);
+	Resample(dst, num_output_frames_resampled, num_input_frames_available, step);
+	for (uint i = num_output_frames_resampled; i < num_output_frames; ++i) {
+		std::memcpy(dst + 2 * i, last_output_frame, sizeof(last_output_frame));
+	}
+}
+
+void Audio::SetSampleRate(uint guest_sample_rate)
+{
+	Audio::guest_sample_rate.store(std::max(1u, guest_sample_rate), std::memory_order_relaxed);
+}
@@ -4,8 +4,19 @@ module;
 
 export module Audio;
 
+import Util;
+
+import <algorithm>;
+import <array>;
+import <atomic>;
+import <bit>;
+import <cstring>;
 import <format>;
 
+import <emmintrin.h>;
+import <smmintrin.h>;
+import <tmmintrin.h>;
+
 namespace Audio
 {
 	export
@@ -15,7 +26,41 @@ namespace Audio
 		void Disable();
 		void Enable();
 		bool Init();
+		void PushSamples(u8 const* samples, size_t num_bytes);
+		void SetSampleRate(uint guest_sample_rate);
 	}
 
+	u32 ComputeStep();
+	uint GetInputFramesAvailable();
+	bool HostHasSse41();
+	void Resample(s16* dst, uint num_output_frames, uint num_input_frames_available, u32 step);
+	void SdlAudioCallback(void* userdata, u8* stream, int len);
+
+	/* Single-producer (emulation thread; AI DMA), single-consumer (SDL audio thread) ring buffer
+	   holding big-endian, interleaved 16-bit stereo samples, as read from RDRAM. */
+	constexpr size_t ring_buffer_size = 0x1'0000; /* bytes; must be a power of two */
+	static_assert(std::has_single_bit(ring_buffer_size));
+	constexpr size_t bytes_per_frame = 4; /* one 16-bit sample per channel */
+
+	/* The consumer nudges its resampling ratio by up to this amount, in order to keep the ring buffer at 'target_fill'.
+	   The producer, in turn, waits while the ring buffer is above 'max_fill', which makes audio pace the emulation. */
+	constexpr f64 max_rate_deviation = 0.005;
+	constexpr size_t target_fill = 0x2000; /* bytes */
+	constexpr size_t max_fill = 2 * target_fill;
+	constexpr uint max_producer_wait_ms = 50; /* guard against stalling the emulation if the device stops consuming */
+
+	constexpr uint resample_frac_bits = 16;
+
+	alignas(64) std::array<u8, ring_buffer_size> ring_buffer;
+	alignas(64) std::atomic<size_t> ring_read_pos; /* written only by the consumer */
+	alignas(64) std::atomic<size_t> ring_write_pos; /* written only by the producer */
+
+	std::atomic<uint> guest_sample_rate;
+	uint host_sample_rate;
+	u64 resample_pos; /* position in frames relative to 'ring_read_pos', with 'resample_frac_bits' fractional bits */
+	s16 last_output_frame[2];
+
+	bool audio_enabled;
+	bool use_sse41; /* otherwise, the scalar resampling loop handles every frame */
 	SDL_AudioDeviceID audio_device_id;
-}
\ No newline at end of file
+}
@@ -0,0 +1,293 @@
+module BatchRunner;
+
+import BuildOptions;
+import FrameTiming;
+import N64;
+import RDRAM;
+import VI;
+
+std::vector<std::filesystem::path> BatchRunner::FindRoms(std::filesystem::path const& rom_dir)
+{
+	static constexpr std::array<std::string_view, 6> rom_exts = { ".n64", ".N64", ".v64", ".V64", ".z64", ".Z64" };
+	std::vector<std::filesystem::path> roms;
+	if (std::filesystem::is_regular_file(rom_dir)) {
+		roms.push_back(rom_dir);
+		return roms;
+	}
+	std::error_code ec;
+	for (auto const& entry : std::filesystem::recursive_directory_iterator(rom_dir, ec)) {
+		if (entry.is_regular_file() && std::ranges::find(rom_exts, entry.path().extension().string()) != rom_exts.end()) {
+			roms.push_back(entry.path());
+		}
+	}
+	std::ranges::sort(roms); /* so that reports of different runs line up */
+	return roms;
+}
+
+u64 BatchRunner::HashFramebuffer()
+{
+	/* FNV-1a over the framebuffer bytes as they are laid out in RDRAM. A blank screen hashes to the offset basis. */
+	VI::Registers const& vi = VI::ReadAllRegisters();
+	u32 pixel_type = vi.ctrl & 3;
+	if (pixel_type < 2) {
+		return fnv_offset_basis;
+	}
+	u32 bytes_per_pixel = pixel_type == 3 ? 4 : 2;
+	u32 width = vi.width & 0xFFF;
+	u32 v_start = vi.v_video >> 16 & 0x3FF;
+	u32 v_end = vi.v_video & 0x3FF;
+	u32 y_scale = vi.y_scale & 0xFFF;
+	u32 height = v_end > v_start ? ((v_end - v_start) / 2 * y_scale) >> 10 : 0;
+	size_t num_bytes = std::min(size_t(width) * height * bytes_per_pixel, RDRAM::GetSize());
+	u32 origin = vi.origin & 0xFF'FFFF;
+
+	u64 hash = fnv_offset_basis;
+	size_t bytes_until_end = RDRAM::GetNumberOfBytesUntilMemoryEnd(origin);
+	u8 const* fb = RDRAM::GetPointerToMemory(origin);
+	for (size_t i = 0; i < num_bytes; ++i) {
+		u8 byte = i < bytes_until_end ? fb[i] : *RDRAM::GetPointerToMemory(u32(i - bytes_until_end));
+		hash = (hash ^ byte) * fnv_prime;
+	}
+	return hash;
+}
+
+std::string BatchRunner::JsonEscape(std::string_view str)
+{
+	std::string escaped;
+	escaped.reserve(str.size());
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			escaped.push_back('\\');
+			escaped.push_back(c);
+		}
+		else if (u8(c) < 0x20) {
+			escaped += std::format("\\u{:04x}", int(c));
+		}
+		else {
+			escaped.push_back(c);
+		}
+	}
+	return escaped;
+}
+
+std::unordered_map<std::string, u64> BatchRunner::LoadGoldenHashes(std::filesystem::path const& path)
+{
+	/* One line per rom: the hash as 16 hex digits, a space, and the rom path relative to the rom directory */
+	std::unordered_map<std::string, u64> golden_hashes;
+	std::ifstream ifs{ path };
+	std::string line;
+	while (std::getline(ifs, line)) {
+		if (line.size() < 18 || line[16] != ' ') {
+			continue;
+		}
+		try {
+			golden_hashes[line.substr(17)] = std::stoull(line.substr(0, 16), nullptr, 16);
+		}
+		catch (...) {
+			std::cerr << std::format("[warning] Ignoring malformed line in {}: {}\n", path.string(), line);
+		}
+	}
+	return golden_hashes;
+}
+
+std::optional<BatchRunner::Options> BatchRunner::ParseArgs(std::span<char* const> args)
+{
+	if (args.empty()) {
+		return {};
+	}
+	Options options = {
+		.rom_dir = args[0],
+		.num_jobs = std::max(1u, std::thread::hardware_concurrency()),
+		.num_frames = default_num_frames,
+		.update_golden = false
+	};
+	for (size_t i = 1; i < args.size(); ++i) {
+		std::string_view arg = args[i];
+		bool has_value = i + 1 < args.size();
+		try {
+			if (arg == "--jobs" && has_value) {
+				options.num_jobs = std::max(1, std::stoi(args[++i]));
+			}
+			else if (arg == "--frames" && has_value) {
+				options.num_frames = std::max(1, std::stoi(args[++i]));
+			}
+			else if (arg == "--movie" && has_value) {
+				options.movie_path = args[++i];
+			}
+			else if (arg == "--golden" && has_value) {
+				options.golden_path = args[++i];
+			}
+			else if (arg == "--report" && has_value) {
+				options.report_path = args[++i];
+			}
+			else if (arg == "--update-golden") {
+				options.update_golden = true;
+			}
+			else {
+				return {};
+			}
+		}
+		catch (...) {
+			return {};
+		}
+	}
+	if (options.update_golden && !options.golden_path.has_value()) {
+		return {};
+	}
+	return options;
+}
+
+void BatchRunner::PrintUsage()
+{
+	std::cerr << "Usage: --batch <rom_dir|rom> [--jobs N] [--frames N] [--movie FILE] [--golden FILE] [--update-golden] [--report FILE]\n"
+		"  --jobs N         number of worker threads (default: number of hardware threads)\n"
+		"  --frames N       number of frames to run each rom for (default: " << default_num_frames << ")\n"
+		"  --movie FILE     input movie to replay from power-on\n"
+		"  --golden FILE    file of golden framebuffer hashes to compare against\n"
+		"  --update-golden  write the resulting hashes to the golden file instead of comparing\n"
+		"  --report FILE    write the report to FILE instead of stdout\n"
+		"Machines run without an RDP implementation, so the hash covers only what the CPU and RSP wrote to the framebuffer.\n"
+		"Files written when a machine stops (profile, instruction histograms, ...) get the rom's index in the report\n"
+		"inserted before their extension, e.g. n64.rom3.folded.\n";
+}
+
+int BatchRunner::Run(std::span<char* const> args)
+{
+	std::optional<Options> options = ParseArgs(args);
+	if (!options.has_value()) {
+		PrintUsage();
+		return 2;
+	}
+	std::vector<std::filesystem::path> roms = FindRoms(options->rom_dir);
+	if (roms.empty()) {
+		std::cerr << std::format("[error] Found no roms in {}\n", options->rom_dir.string());
+		return 2;
+	}
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	/* Each worker thread owns one machine at a time (all emulator core state is thread_local) */
+	std::vector<TestResult> results(roms.size());
+	std::atomic<size_t> next_rom_index = 0;
+	/* Results are named by the rom path relative to the rom directory, or to the directory of the single rom given */
+	std::filesystem::path base_dir = std::filesystem::is_directory(options->rom_dir)
+		? options->rom_dir : std::filesystem::absolute(options->rom_dir).parent_path();
+	{
+		std::vector<std::jthread> workers;
+		uint num_workers = std::min(options->num_jobs, uint(roms.size()));
+		for (uint i = 0; i < num_workers; ++i) {
+			workers.emplace_back([&] {
+				for (size_t j; (j = next_rom_index.fetch_add(1, std::memory_order_relaxed)) < roms.size(); ) {
+					N64::SetOutputFileSuffix(std::format("rom{}", j));
+					results[j] = RunTest(roms[j], options->num_frames, options->movie_path);
+					results[j].name = std::filesystem::relative(roms[j], base_dir).generic_string();
+				}
+			});
+		}
+	}
+
+	f64 total_wall_time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+	std::unordered_map<std::string, u64> golden_hashes;
+	if (options->golden_path.has_value() && !options->update_golden) {
+		golden_hashes = LoadGoldenHashes(options->golden_path.value());
+	}
+	for (TestResult& result : results) {
+		if (!result.hash.has_value()) {
+			result.verdict = Verdict::Error;
+		}
+		else if (auto it = golden_hashes.find(result.name); it != golden_hashes.end()) {
+			result.golden_hash = it->second;
+			result.verdict = it->second == result.hash.value() ? Verdict::Pass : Verdict::Fail;
+		}
+		else {
+			result.verdict = Verdict::New;
+		}
+	}
+
+	if (options->update_golden && !SaveGoldenHashes(options->golden_path.value(), results)) {
+		std::cerr << std::format("[error] Failed to write golden hashes to {}\n", options->golden_path->string());
+	}
+
+	if (options->report_path.has_value()) {
+		std::ofstream ofs{ options->report_path.value() };
+		if (!ofs) {
+			std::cerr << std::format("[error] Failed to open report file {}\n", options->report_path->string());
+			return 2;
+		}
+		WriteReport(ofs, results, total_wall_time_ms);
+	}
+	else {
+		WriteReport(std::cout, results, total_wall_time_ms);
+	}
+
+	bool all_ok = std::ranges::none_of(results, [](TestResult const& result) {
+		return result.verdict == Verdict::Fail || result.verdict == Verdict::Error;
+	});
+	return all_ok ? 0 : 1;
+}
+
+BatchRunner::TestResult BatchRunner::RunTest(std::filesystem::path const& rom_path, uint num_frames,
+	std::optional<std::filesystem::path> const& movie_path)
+{
+	auto start_time = std::chrono::steady_clock::now();
+	TestResult result{};
+	N64::Init(true);
+	if (N64::LoadGame(rom_path) && (!movie_path.has_value() || N64::ReplayInputMovie(movie_path.value()))) {
+		N64::Run(u64(num_frames) * N64::cpu_cycles_per_frame);
+		N64::Stop();
+		N64::StopInputMovie();
+		result.hash = HashFramebuffer();
+		if constexpr (time_subsystems) {
+			result.frame_timing_json = FrameTiming::StatsToJson();
+		}
+	}
+	result.wall_time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+	return result;
+}
+
+bool BatchRunner::SaveGoldenHashes(std::filesystem::path const& path, std::span<TestResult const> results)
+{
+	std::ofstream ofs{ path };
+	if (!ofs) {
+		return false;
+	}
+	for (TestResult const& result : results) {
+		if (result.hash.has_value()) {
+			ofs << std::format("{:016x} {}\n", result.hash.value(), result.name);
+		}
+	}
+	return ofs.good();
+}
+
+constexpr std::string_view BatchRunner::VerdictToStr(Verdict verdict)
+{
+	switch (verdict) {
+	case Verdict::Pass: return "pass";
+	case Verdict::Fail: return "fail";
+	case Verdict::New: return "new";
+	case Verdict::Error: return "error";
+	default: return "unknown";
+	}
+}
+
+void BatchRunner::WriteReport(std::ostream& os, std::span<TestResult const> results, f64 total_wall_time_ms)
+{
+	/* One JSON object per line; one per rom, followed by a summary */
+	auto HashToJson = [](std::optional<u64> hash) {
+		return hash.has_value() ? std::format("\"{:016x}\"", hash.value()) : std::string("null");
+	};
+	std::array<uint, 4> verdict_counts{};
+	for (TestResult const& result : results) {
+		++verdict_counts[std::to_underlying(result.verdict)];
+		os << std::format("{{\"rom\":\"{}\",\"verdict\":\"{}\",\"hash\":{},\"golden\":{},\"wall_ms\":{:.3f}",
+			JsonEscape(result.name), VerdictToStr(result.verdict), HashToJson(result.hash),
+			HashToJson(result.golden_hash), result.wall_time_ms);
+		if (result.frame_timing_json.has_value()) {
+			os << ",\"frame_ms\":" << result.frame_timing_json.value();
+		}
+		os << "}\n";
+	}
+	os << std::format("{{\"summary\":{{\"total\":{},\"pass\":{},\"fail\":{},\"new\":{},\"error\":{},\"wall_ms\":{:.3f}}}}}\n",
+		results.size(), verdict_counts[0], verdict_counts[1], verdict_counts[2], verdict_counts[3], total_wall_time_ms);
+}
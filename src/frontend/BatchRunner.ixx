@@ -0,0 +1,71 @@
+export module BatchRunner;
+
+import Util;
+
+import <algorithm>;
+import <array>;
+import <atomic>;
+import <chrono>;
+import <filesystem>;
+import <format>;
+import <fstream>;
+import <iostream>;
+import <optional>;
+import <span>;
+import <string>;
+import <string_view>;
+import <thread>;
+import <unordered_map>;
+import <utility>;
+import <vector>;
+
+/* Headless test rom runner. Every rom in a directory (or a single rom) is run for a fixed number of frames on one
+   of several worker threads, each owning its own machine, optionally replaying an input movie. The VI framebuffer
+   is then hashed and compared against a file of golden hashes, and a report is written as newline-delimited JSON.
+   With 'time_subsystems', the report also gives percentiles of the host time per frame spent in each subsystem.
+   Usage: --batch <rom_dir|rom> [--jobs N] [--frames N] [--movie FILE] [--golden FILE] [--update-golden] [--report FILE] */
+namespace BatchRunner
+{
+	export
+	{
+		u64 HashFramebuffer(); /* of the machine owned by the calling thread */
+		std::string JsonEscape(std::string_view str);
+		int Run(std::span<char* const> args); /* returns the process exit code */
+	}
+
+	enum class Verdict {
+		Pass, Fail, New, Error
+	};
+
+	struct Options {
+		std::filesystem::path rom_dir;
+		std::optional<std::filesystem::path> golden_path;
+		std::optional<std::filesystem::path> movie_path;
+		std::optional<std::filesystem::path> report_path;
+		uint num_jobs;
+		uint num_frames;
+		bool update_golden;
+	};
+
+	struct TestResult {
+		std::string name; /* rom path relative to the rom directory; the key in the golden file */
+		std::optional<u64> hash; /* empty if the rom could not be loaded */
+		std::optional<u64> golden_hash;
+		Verdict verdict;
+		f64 wall_time_ms;
+		std::optional<std::string> frame_timing_json; /* see FrameTiming; only with 'time_subsystems' */
+	};
+
+	std::vector<std::filesystem::path> FindRoms(std::filesystem::path const& rom_dir);
+	std::unordered_map<std::string, u64> LoadGoldenHashes(std::filesystem::path const& path);
+	std::optional<Options> ParseArgs(std::span<char* const> args);
+	void PrintUsage();
+	TestResult RunTest(std::filesystem::path const& rom_path, uint num_frames, std::optional<std::filesystem::path> const& movie_path);
+	bool SaveGoldenHashes(std::filesystem::path const& path, std::span<TestResult const> results);
+	constexpr std::string_view VerdictToStr(Verdict verdict);
+	void WriteReport(std::ostream& os, std::span<TestResult const> results, f64 total_wall_time_ms);
+
+	constexpr uint default_num_frames = 300;
+	constexpr u64 fnv_offset_basis = 0xCBF2'9CE4'8422'2325;
+	constexpr u64 fnv_prime = 0x100'0000'01B3;
+}
@@ -0,0 +1,132 @@
+module BenchRunner;
+
+import Bench;
+import Memory;
+import N64;
+import RDP;
+import RDPImplementation;
+import RDRAM;
+import RSP;
+import Scheduler;
+import VR4300;
+
+std::vector<u32> BenchRunner::MakeDisplayList()
+{
+	/* A synthetic list resembling a game's: per object, a pipe sync, render state changes, a tile load, a few
+	   shaded and textured triangles, and a rectangle or two; then a full sync. The words are laid out as the
+	   command processor currently decodes them, i.e. with the opcode in the low six bits of the first word of
+	   each command (see LoadExecuteCommands in RDP). */
+	std::mt19937 rng{ 0x5EED };
+	std::vector<u32> words;
+	auto Append = [&](u32 opcode, uint num_words) {
+		words.push_back(u32(rng()) & ~0x3Fu | opcode);
+		for (uint i = 1; i < num_words; ++i) {
+			words.push_back(u32(rng()));
+		}
+	};
+	for (uint i = 0; i < display_list_num_objects; ++i) {
+		Append(0x27, 2); /* sync pipe */
+		Append(0x2F, 2); /* set other modes */
+		Append(0x3C, 2); /* set combine mode */
+		Append(0x3A, 2); /* set primitive color */
+		Append(0x35, 2); /* set tile */
+		Append(0x34, 2); /* load tile */
+		for (int j = 0; j < 4; ++j) {
+			Append(0x0E, 40); /* shaded, textured triangle */
+		}
+		Append(0x24, 4); /* texture rectangle */
+		Append(0x36, 2); /* fill rectangle */
+	}
+	Append(0x29, 2); /* sync full */
+	return words;
+}
+
+std::optional<BenchRunner::Options> BenchRunner::ParseArgs(std::span<char* const> args)
+{
+	Options options;
+	for (size_t i = 0; i < args.size(); ++i) {
+		std::string_view arg = args[i];
+		bool has_value = i + 1 < args.size();
+		if (arg == "--filter" && has_value) {
+			options.filter = args[++i];
+		}
+		else if (arg == "--rom" && has_value) {
+			options.rom_path = args[++i];
+		}
+		else {
+			return {};
+		}
+	}
+	return options;
+}
+
+void BenchRunner::PrintUsage()
+{
+	std::cerr << "Usage: --bench [--filter STR] [--rom FILE]\n"
+		"  --filter STR  only run benchmarks whose name contains STR\n"
+		"  --rom FILE    load a rom, so that cartridge reads can be measured\n";
+}
+
+int BenchRunner::Run(std::span<char* const> args)
+{
+	std::optional<Options> options = ParseArgs(args);
+	if (!options.has_value()) {
+		PrintUsage();
+		return 2;
+	}
+	Bench::SetFilter(options->filter);
+
+	N64::Init(true);
+	RSP::RunBenchmarks();
+	N64::Init(true);
+	VR4300::RunBenchmarks();
+	N64::Init(true);
+	Scheduler::RunBenchmarks();
+	N64::Init(true);
+	bool rom_loaded = options->rom_path.has_value() && N64::LoadGame(options->rom_path.value());
+	if (options->rom_path.has_value() && !rom_loaded) {
+		std::cerr << std::format("[error] Failed to load rom at path {}\n", options->rom_path->string());
+		return 1;
+	}
+	RunMemoryBenchmarks(rom_loaded);
+	N64::Init(true);
+	RunRdpBenchmarks();
+	return 0;
+}
+
+void BenchRunner::RunMemoryBenchmarks(bool rom_loaded)
+{
+	/* Physical reads as the CPU does them on a cache miss or in an uncached segment, per region */
+	auto MeasureRegion = [](std::string_view region, u32 base, u32 mask) {
+		Bench::Measure(std::format("Memory::Read<s32> {}", region), [base, mask](u64 i) {
+			Bench::Consume(Memory::Read<s32>(base + (u32(i * 4) & mask)));
+		});
+	};
+	MeasureRegion("RDRAM", 0, 0xF'FFFC);
+	MeasureRegion("RSP DMEM", 0x0400'0000, 0xFFC);
+	MeasureRegion("MI registers", 0x0430'0000, 0xC);
+	MeasureRegion("VI registers", 0x0440'0000, 0x1C);
+	MeasureRegion("PI registers", 0x0460'0000, 0x1C);
+	MeasureRegion("SI registers", 0x0480'0000, 0x4);
+	MeasureRegion("PIF RAM", 0x1FC0'07C0, 0x3C);
+	if (rom_loaded) {
+		MeasureRegion("cartridge ROM", 0x1000'0000, 0xF'FFFC);
+	}
+}
+
+void BenchRunner::RunRdpBenchmarks()
+{
+	/* Submission of a whole display list through the DP command registers, as the RSP or CPU would do it.
+	   The commands are copied to the command buffer, split, and handed to an implementation that drops them. */
+	std::vector<u32> words = MakeDisplayList();
+	for (size_t i = 0; i < words.size(); i += 2) {
+		RDRAM::Write<8>(display_list_addr + u32(4 * i), s64(u64(words[i + 1]) << 32 | words[i]));
+	}
+	u32 display_list_end = display_list_addr + u32(4 * words.size());
+	RDP::implementation = std::make_unique<NullRDPImplementation>();
+	Bench::Measure(std::format("RDP display list ({} words)", words.size()), [display_list_end](u64) {
+		Memory::Write<4>(0x0410'0000, display_list_addr); /* DPC_START */
+		Memory::Write<4>(0x0410'0004, display_list_end); /* DPC_END */
+	});
+	RDP::implementation.reset();
+}
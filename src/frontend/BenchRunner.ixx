@@ -0,0 +1,40 @@
+export module BenchRunner;
+
+import Util;
+
+import <filesystem>;
+import <format>;
+import <iostream>;
+import <memory>;
+import <optional>;
+import <random>;
+import <span>;
+import <string>;
+import <string_view>;
+import <vector>;
+
+/* Microbenchmarks of the emulator's hot kernels (see Bench): RSP vector instructions, TLB lookups, cache accesses,
+   the scheduler, physical memory reads per region, and RDP command list submission. Each suite runs on a freshly
+   initialized headless machine. A rom is only needed for the cartridge read benchmark, which is skipped without one.
+   Usage: --bench [--filter STR] [--rom FILE] */
+namespace BenchRunner
+{
+	export
+	{
+		int Run(std::span<char* const> args); /* returns the process exit code */
+	}
+
+	struct Options {
+		std::optional<std::filesystem::path> rom_path;
+		std::string filter;
+	};
+
+	std::vector<u32> MakeDisplayList();
+	std::optional<Options> ParseArgs(std::span<char* const> args);
+	void PrintUsage();
+	void RunMemoryBenchmarks(bool rom_loaded);
+	void RunRdpBenchmarks();
+
+	constexpr u32 display_list_addr = 0x10'0000;
+	constexpr uint display_list_num_objects = 256;
+}
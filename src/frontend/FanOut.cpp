@@ -0,0 +1,266 @@
+module;
+
+#ifndef _WIN64
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+module FanOut;
+
+import BatchRunner;
+import N64;
+
+void FanOut::ApplyInputEvent(InputEvent const& event)
+{
+	if (event.control == N64::Control::JX || event.control == N64::Control::JY) {
+		N64::OnJoystickMovement(event.control, event.value);
+	}
+	else if (event.value) {
+		N64::OnButtonDown(event.control);
+	}
+	else {
+		N64::OnButtonUp(event.control);
+	}
+}
+
+std::optional<std::vector<FanOut::InputEvent>> FanOut::LoadInputScript(std::filesystem::path const& path)
+{
+	std::ifstream ifs{ path };
+	if (!ifs) {
+		return {};
+	}
+	std::vector<InputEvent> script;
+	std::string line;
+	while (std::getline(ifs, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		std::istringstream iss{ line };
+		uint frame;
+		std::string control_name;
+		int value;
+		if (!(iss >> frame >> control_name >> value)) {
+			std::cerr << std::format("[error] Malformed line in input script {}: {}\n", path.string(), line);
+			return {};
+		}
+		std::optional<N64::Control> control = ParseControl(control_name);
+		if (!control.has_value()) {
+			std::cerr << std::format("[error] Unknown control '{}' in input script {}\n", control_name, path.string());
+			return {};
+		}
+		script.emplace_back(frame, control.value(), s16(std::clamp(value, -32768, 32767)));
+	}
+	std::ranges::stable_sort(script, {}, &InputEvent::frame);
+	return script;
+}
+
+std::optional<FanOut::Options> FanOut::ParseArgs(std::span<char* const> args)
+{
+	if (args.empty()) {
+		return {};
+	}
+	Options options = {
+		.rom_path = args[0],
+		.num_jobs = std::max(1u, std::thread::hardware_concurrency()),
+		.num_prefix_frames = default_num_prefix_frames,
+		.num_frames = default_num_frames
+	};
+	for (size_t i = 1; i < args.size(); ++i) {
+		std::string_view arg = args[i];
+		bool has_value = i + 1 < args.size();
+		try {
+			if (arg == "--jobs" && has_value) {
+				options.num_jobs = std::max(1, std::stoi(args[++i]));
+			}
+			else if (arg == "--prefix-frames" && has_value) {
+				options.num_prefix_frames = std::max(0, std::stoi(args[++i]));
+			}
+			else if (arg == "--frames" && has_value) {
+				options.num_frames = std::max(1, std::stoi(args[++i]));
+			}
+			else if (arg == "--report" && has_value) {
+				options.report_path = args[++i];
+			}
+			else if (!arg.starts_with("--")) {
+				options.script_paths.emplace_back(arg);
+			}
+			else {
+				return {};
+			}
+		}
+		catch (...) {
+			return {};
+		}
+	}
+	if (options.script_paths.empty()) {
+		return {};
+	}
+	return options;
+}
+
+std::optional<N64::Control> FanOut::ParseControl(std::string_view name)
+{
+	auto it = control_names.find(name);
+	return it != control_names.end() ? std::optional(it->second) : std::nullopt;
+}
+
+void FanOut::PrintUsage()
+{
+	std::cerr << "Usage: --fanout <rom> <script>... [--prefix-frames N] [--frames N] [--jobs N] [--report FILE]\n"
+		"  --prefix-frames N  number of frames to run before forking (default: " << default_num_prefix_frames << ")\n"
+		"  --frames N         number of frames each child runs its script for (default: " << default_num_frames << ")\n"
+		"  --jobs N           maximum number of children running at once (default: number of hardware threads)\n"
+		"  --report FILE      write the report to FILE instead of stdout\n"
+		"Machines run without an RDP implementation, so the hash covers only what the CPU and RSP wrote to the framebuffer.\n"
+		"Files written when a child stops (profile, instruction histograms, ...) get the script's index inserted\n"
+		"before their extension, e.g. n64.script3.folded.\n"
+		"Input scripts consist of lines '<frame> <control> <value>', with frames counted from the fork point.\n"
+		"Controls: A B Z Start L R CUp CDown CLeft CRight DUp DDown DLeft DRight (value 1 or 0), JX JY (value -32768..32767)\n";
+}
+
+int FanOut::Run(std::span<char* const> args)
+{
+#ifdef _WIN64
+	std::cerr << "[error] --fanout requires fork(), which is not available on Windows.\n";
+	return 2;
+#else
+	std::optional<Options> options = ParseArgs(args);
+	if (!options.has_value()) {
+		PrintUsage();
+		return 2;
+	}
+
+	std::vector<ChildResult> results(options->script_paths.size());
+	std::vector<std::optional<std::vector<InputEvent>>> scripts;
+	for (size_t i = 0; i < options->script_paths.size(); ++i) {
+		results[i].name = options->script_paths[i].generic_string();
+		scripts.push_back(LoadInputScript(options->script_paths[i]));
+	}
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	/* Run the shared prefix once, on this thread, so that forked children inherit the machine */
+	N64::Init(true);
+	if (!N64::LoadGame(options->rom_path)) {
+		std::cerr << std::format("[error] Failed to load rom at path {}\n", options->rom_path.string());
+		return 2;
+	}
+	N64::Run(u64(options->num_prefix_frames) * N64::cpu_cycles_per_frame);
+
+	f64 prefix_wall_time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+	/* The result of a child is sent back over a pipe; it exits with _exit so as to not flush stdio buffers
+	   inherited from the parent. */
+	struct ChildMessage {
+		u64 hash;
+		f64 wall_time_ms;
+	};
+	struct Child {
+		size_t result_index;
+		int read_fd;
+	};
+	std::unordered_map<pid_t, Child> children;
+
+	auto ReapChild = [&] {
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid <= 0) {
+			return false;
+		}
+		if (auto it = children.find(pid); it != children.end()) {
+			ChildMessage message;
+			if (WIFEXITED(status) && WEXITSTATUS(status) == 0
+				&& read(it->second.read_fd, &message, sizeof(message)) == sizeof(message)) {
+				results[it->second.result_index].hash = message.hash;
+				results[it->second.result_index].wall_time_ms = message.wall_time_ms;
+			}
+			close(it->second.read_fd);
+			children.erase(it);
+		}
+		return true;
+	};
+
+	std::cout.flush();
+	std::cerr.flush();
+	for (size_t i = 0; i < scripts.size(); ++i) {
+		if (!scripts[i].has_value()) {
+			continue;
+		}
+		while (children.size() >= options->num_jobs && ReapChild()) {}
+		int fds[2];
+		if (pipe(fds) != 0) {
+			std::cerr << std::format("[error] pipe() failed for script {}\n", results[i].name);
+			continue;
+		}
+		pid_t pid = fork();
+		if (pid == 0) {
+			close(fds[0]);
+			N64::SetOutputFileSuffix(std::format("script{}", i));
+			auto child_start_time = std::chrono::steady_clock::now();
+			ChildMessage message = {
+				.hash = RunChild(scripts[i].value(), options->num_frames),
+				.wall_time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - child_start_time).count()
+			};
+			bool ok = write(fds[1], &message, sizeof(message)) == sizeof(message);
+			_exit(ok ? 0 : 1);
+		}
+		close(fds[1]);
+		if (pid < 0) {
+			std::cerr << std::format("[error] fork() failed for script {}\n", results[i].name);
+			close(fds[0]);
+			continue;
+		}
+		children.emplace(pid, Child{ .result_index = i, .read_fd = fds[0] });
+	}
+	while (!children.empty() && ReapChild()) {}
+
+	N64::Stop();
+
+	f64 total_wall_time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+	if (options->report_path.has_value()) {
+		std::ofstream ofs{ options->report_path.value() };
+		if (!ofs) {
+			std::cerr << std::format("[error] Failed to open report file {}\n", options->report_path->string());
+			return 2;
+		}
+		WriteReport(ofs, results, prefix_wall_time_ms, total_wall_time_ms);
+	}
+	else {
+		WriteReport(std::cout, results, prefix_wall_time_ms, total_wall_time_ms);
+	}
+
+	bool all_ok = std::ranges::all_of(results, [](ChildResult const& result) { return result.hash.has_value(); });
+	return all_ok ? 0 : 1;
+#endif
+}
+
+u64 FanOut::RunChild(std::span<InputEvent const> script, uint num_frames)
+{
+	/* Events are applied at frame granularity: all events of a frame are fed to the PIF before it is run */
+	auto event_it = script.begin();
+	for (uint frame = 0; frame < num_frames; ++frame) {
+		for (; event_it != script.end() && event_it->frame <= frame; ++event_it) {
+			ApplyInputEvent(*event_it);
+		}
+		N64::Run(N64::cpu_cycles_per_frame);
+	}
+	N64::Stop();
+	return BatchRunner::HashFramebuffer();
+}
+
+void FanOut::WriteReport(std::ostream& os, std::span<ChildResult const> results, f64 prefix_wall_time_ms, f64 total_wall_time_ms)
+{
+	/* One JSON object per line; one per script, followed by a summary */
+	size_t num_errors = 0;
+	for (ChildResult const& result : results) {
+		num_errors += !result.hash.has_value();
+		os << std::format("{{\"script\":\"{}\",\"hash\":{},\"wall_ms\":{:.3f}}}\n",
+			BatchRunner::JsonEscape(result.name),
+			result.hash.has_value() ? std::format("\"{:016x}\"", result.hash.value()) : std::string("null"),
+			result.wall_time_ms);
+	}
+	os << std::format("{{\"summary\":{{\"total\":{},\"error\":{},\"prefix_wall_ms\":{:.3f},\"wall_ms\":{:.3f}}}}}\n",
+		results.size(), num_errors, prefix_wall_time_ms, total_wall_time_ms);
+}
@@ -0,0 +1,76 @@
+export module FanOut;
+
+import N64;
+import Util;
+
+import <algorithm>;
+import <chrono>;
+import <filesystem>;
+import <format>;
+import <fstream>;
+import <iostream>;
+import <optional>;
+import <span>;
+import <sstream>;
+import <string>;
+import <string_view>;
+import <thread>;
+import <unordered_map>;
+import <vector>;
+
+/* Input-space exploration from a shared checkpoint. A rom is booted and run for a number of frames once, after
+   which the process forks one child per input script. The children start from the parent's machine state;
+   RDRAM, the rom, and the recompiler's code buffer are shared copy-on-write, so only the pages a child dirties
+   get copied. Each child feeds its script to the PIF, runs for a number of frames, and reports a hash of the
+   framebuffer. A report is written as newline-delimited JSON, like the batch runner's.
+   Requires fork(); not available on Windows.
+   Usage: --fanout <rom> <script>... [--prefix-frames N] [--frames N] [--jobs N] [--report FILE] */
+namespace FanOut
+{
+	export
+	{
+		int Run(std::span<char* const> args); /* returns the process exit code */
+	}
+
+	/* One line of an input script: '<frame> <control> <value>', where frame counts from the fork point.
+	   Buttons take 1 (press) or 0 (release); the joystick axes JX and JY take a value in [-32768, 32767]. */
+	struct InputEvent {
+		uint frame;
+		N64::Control control;
+		s16 value;
+	};
+
+	struct Options {
+		std::filesystem::path rom_path;
+		std::vector<std::filesystem::path> script_paths;
+		std::optional<std::filesystem::path> report_path;
+		uint num_jobs;
+		uint num_prefix_frames;
+		uint num_frames;
+	};
+
+	struct ChildResult {
+		std::string name; /* the script path */
+		std::optional<u64> hash; /* empty if the script could not be parsed or the child died */
+		f64 wall_time_ms;
+	};
+
+	void ApplyInputEvent(InputEvent const& event);
+	std::optional<std::vector<InputEvent>> LoadInputScript(std::filesystem::path const& path);
+	std::optional<Options> ParseArgs(std::span<char* const> args);
+	std::optional<N64::Control> ParseControl(std::string_view name);
+	void PrintUsage();
+	u64 RunChild(std::span<InputEvent const> script, uint num_frames);
+	void WriteReport(std::ostream& os, std::span<ChildResult const> results, f64 prefix_wall_time_ms, f64 total_wall_time_ms);
+
+	constexpr uint default_num_prefix_frames = 600;
+	constexpr uint default_num_frames = 300;
+
+	const std::unordered_map<std::string_view, N64::Control> control_names = {
+		{ "A", N64::Control::A }, { "B", N64::Control::B }, { "Z", N64::Control::Z }, { "Start", N64::Control::Start },
+		{ "L", N64::Control::ShoulderL }, { "R", N64::Control::ShoulderR },
+		{ "CUp", N64::Control::CUp }, { "CDown", N64::Control::CDown }, { "CLeft", N64::Control::CLeft }, { "CRight", N64::Control::CRight },
+		{ "DUp", N64::Control::DUp }, { "DDown", N64::Control::DDown }, { "DLeft", N64::Control::DLeft }, { "DRight", N64::Control::DRight },
+		{ "JX", N64::Control::JX }, { "JY", N64::Control::JY }
+	};
+}
@@ -11,9 +11,12 @@ module Gui;
 
 import Audio;
 import BuildOptions;
+import FrameTiming;
 import Input;
+import Log;
 import N64;
 import RDP;
+import RDPCapture;
 import UserMessage;
 import Vulkan;
 
@@ -34,6 +37,43 @@ void Gui::Draw()
 	if (show_rdp_conf_window) {
 		DrawRdpConfWindow();
 	}
+	if (show_frame_timing_window) {
+		DrawFrameTimingWindow();
+	}
+}
+
+void Gui::DrawFrameTimingWindow()
+{
+	/* Host time per emulated frame, averaged over the last second, and the frame time history */
+	ImGui::SetNextWindowBgAlpha(0.6f);
+	if (ImGui::Begin("Frame timing", &show_frame_timing_window, ImGuiWindowFlags_AlwaysAutoResize)) {
+		std::span<FrameTiming::Frame const> frames = FrameTiming::GetFrames();
+		std::span<FrameTiming::Frame const> last_second = frames.last(std::min(frames.size(), size_t(60)));
+		if (last_second.empty()) {
+			ImGui::Text("No frames emulated yet");
+		}
+		else {
+			f32 total_ms = 0.0f;
+			std::array<f32, FrameTiming::num_units> unit_ms{};
+			for (FrameTiming::Frame const& frame : last_second) {
+				total_ms += frame.total_ms;
+				for (size_t i = 0; i < FrameTiming::num_units; ++i) {
+					unit_ms[i] += frame.unit_ms[i];
+				}
+			}
+			f32 num_frames = f32(last_second.size());
+			ImGui::Text("%.2f ms/frame (%.1f fps)", total_ms / num_frames, 1000.0f * num_frames / total_ms);
+			ImGui::Separator();
+			for (size_t i = 0; i < FrameTiming::num_units; ++i) {
+				ImGui::Text("%-8s %6.2f ms  %5.1f%%", FrameTiming::UnitToStr(FrameTiming::Unit(i)).data(),
+					unit_ms[i] / num_frames, 100.0f * unit_ms[i] / total_ms);
+			}
+			std::span<FrameTiming::Frame const> history = frames.last(std::min(frames.size(), size_t(240)));
+			ImGui::PlotLines("##history", &history[0].total_ms, int(history.size()), 0, "ms/frame",
+				0.0f, 2.0f * 1000.0f / 60.0f, ImVec2(240, 60), sizeof(FrameTiming::Frame));
+		}
+	}
+	ImGui::End();
 }
 
 void Gui::DrawGameSelectionWindow()
@@ -203,6 +243,15 @@ void Gui::DrawMenu()
 			if (ImGui::MenuItem("Stop", "Ctrl+X")) {
 				OnMenuStop();
 			}
+			if (ImGui::BeginMenu("Run-ahead")) {
+				for (int frames = 0; frames <= max_run_ahead_frames; ++frames) {
+					if (ImGui::MenuItem(frames == 0 ? "Off" : std::format("{} frame{}", frames, frames > 1 ? "s" : "").c_str(),
+						nullptr, menu_run_ahead_frames == frames)) {
+						OnMenuRunAhead(frames);
+					}
+				}
+				ImGui::EndMenu();
+			}
 			ImGui::EndMenu();
 		}
 		if (ImGui::BeginMenu("Audio")) {
@@ -225,10 +274,33 @@ void Gui::DrawMenu()
 			if (ImGui::MenuItem("Configure bindings")) {
 				OnMenuConfigureBindings();
 			}
+			if (ImGui::MenuItem("Record input movie")) {
+				OnMenuRecordInputMovie();
+			}
+			if (ImGui::MenuItem("Replay input movie")) {
+				OnMenuReplayInputMovie();
+			}
+			if (ImGui::MenuItem("Stop input movie")) {
+				OnMenuStopInputMovie();
+			}
 			ImGui::EndMenu();
 		}
 		if (ImGui::BeginMenu("Debug")) {
-			// TODO
+			bool capturing_rdp_commands = RDPCapture::IsCapturing();
+			if (ImGui::MenuItem("Capture RDP commands", nullptr, &capturing_rdp_commands, capture_rdp_commands)) {
+				OnMenuCaptureRdpCommands(capturing_rdp_commands);
+			}
+			ImGui::MenuItem("Frame timing", nullptr, &show_frame_timing_window, time_subsystems);
+			if (ImGui::BeginMenu("Logging", enable_file_logging)) {
+				for (size_t i = 0; i < Log::num_categories; ++i) {
+					Log::Category category = Log::Category(i);
+					bool enabled = Log::IsEnabled(category);
+					if (ImGui::MenuItem(Log::CategoryToStr(category).data(), nullptr, &enabled, true)) {
+						OnMenuLogCategory(category, enabled);
+					}
+				}
+				ImGui::EndMenu();
+			}
 			ImGui::EndMenu();
 		}
 		ImGui::EndMainMenuBar();
@@ -281,6 +353,21 @@ std::optional<fs::path> Gui::FileDialog()
 	return {};
 }
 
+std::optional<fs::path> Gui::SaveFileDialog()
+{
+	nfdnchar_t* path{};
+	nfdresult_t result = NFD_SaveDialogN(&path, nullptr, 0, fs::current_path().c_str(), nullptr);
+	if (result == NFD_OKAY) {
+		fs::path fs_path{ path };
+		NFD_FreePathN(path);
+		return fs_path;
+	}
+	else if (result == NFD_ERROR) {
+		UserMessage::Error("nativefiledialog returned NFD_ERROR for NFD_SaveDialogN");
+	}
+	return {};
+}
+
 std::optional<fs::path> Gui::FolderDialog()
 {
 	nfdnchar_t* path{};
@@ -331,6 +418,26 @@ void Gui::GetWindowSize(int* w, int* h)
 	SDL_GetWindowSize(sdl_window, w, h);
 }
 
+void Gui::HandleEvent(SDL_Event const& event)
+{
+	ImGui_ImplSDL2_ProcessEvent(&event);
+	switch (event.type) {
+	case SDL_AUDIODEVICEADDED       : Audio::OnDeviceAdded(event);             break;
+	case SDL_AUDIODEVICEREMOVED     : Audio::OnDeviceRemoved(event);           break;
+	case SDL_CONTROLLERAXISMOTION   : Input::OnControllerAxisMotion(event);    break;
+	case SDL_CONTROLLERBUTTONDOWN   : Input::OnControllerButtonDown(event);    break;
+	case SDL_CONTROLLERBUTTONUP     : Input::OnControllerButtonUp(event);      break;
+	case SDL_CONTROLLERDEVICEADDED  : Input::OnControllerDeviceAdded(event);   break;
+	case SDL_CONTROLLERDEVICEREMOVED: Input::OnControllerDeviceRemoved(event); break;
+	case SDL_KEYDOWN                : Input::OnKeyDown(event);                 break;
+	case SDL_KEYUP                  : Input::OnKeyUp(event);                   break;
+	case SDL_MOUSEBUTTONDOWN        : Input::OnMouseButtonDown(event);         break;
+	case SDL_MOUSEBUTTONUP          : Input::OnMouseButtonUp(event);           break;
+	case SDL_QUIT                   : OnSdlQuit();                             break;
+	case SDL_WINDOWEVENT_RESIZED    : OnWindowResizeEvent(event);              break;
+	}
+}
+
 bool Gui::Init()
 {
 	window_width = 640, window_height = 480;
@@ -339,6 +446,7 @@ bool Gui::Init()
 	menu_enable_audio = true;
 	menu_fullscreen = false;
 	menu_pause_emulation = false;
+	menu_run_ahead_frames = 0;
 	quit = false;
 	show_input_bindings_window = false;
 	show_menu = true;
@@ -369,6 +477,7 @@ bool Gui::Init()
 	if (!Input::Init()) {
 		std::cerr << "[error] Failed to init input system!\n";
 	}
+	N64::SetInputLatchCallback(LatchInput);
 	if (nfdresult_t result = NFD_Init(); result != NFD_OKAY) {
 		std::cerr << "[error] Failed to init nativefiledialog; NFD_Init returned " << std::to_underlying(result) << '\n';
 	}
@@ -446,9 +555,46 @@ bool Gui::InitSdl()
 	return true;
 }
 
+void Gui::LatchInput()
+{
+	/* Called by the PIF right before it answers a controller state poll. Emulation runs on the thread that owns
+	   the SDL window, so the event queue can be pumped here. This is in the middle of a guest instruction, so only
+	   controller and key events are applied, and only to the joypad state through the bindings. Key presses with
+	   Ctrl held are hotkeys that may stop or reset the machine. Events are taken off the front of the queue for as
+	   long as they can be applied; the first one that cannot, and everything after it, is left in order for
+	   PollEvents, which runs between frames. */
+	SDL_PumpEvents();
+	auto IsJoypadInput = [](SDL_Event const& event) {
+		switch (event.type) {
+		case SDL_CONTROLLERAXISMOTION:
+		case SDL_CONTROLLERBUTTONDOWN:
+		case SDL_CONTROLLERBUTTONUP:
+		case SDL_KEYUP:
+			return true;
+		case SDL_KEYDOWN:
+			return (event.key.keysym.mod & KMOD_CTRL) == 0;
+		default:
+			return false;
+		}
+	};
+	SDL_Event event;
+	while (SDL_PeepEvents(&event, 1, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) > 0 && IsJoypadInput(event)) {
+		SDL_PeepEvents(&event, 1, SDL_GETEVENT, event.type, event.type); /* the peeked event, as it is the first */
+		switch (event.type) {
+		case SDL_CONTROLLERAXISMOTION: Input::OnControllerAxisMotion(event); break;
+		case SDL_CONTROLLERBUTTONDOWN: Input::OnControllerButtonDown(event); break;
+		case SDL_CONTROLLERBUTTONUP  : Input::OnControllerButtonUp(event);   break;
+		case SDL_KEYDOWN             : Input::OnKeyDown(event);              break;
+		case SDL_KEYUP               : Input::OnKeyUp(event);                break;
+		}
+		ImGui_ImplSDL2_ProcessEvent(&event); /* only records the event for the next GUI frame */
+	}
+}
+
 bool Gui::NeedsDraw()
 {
-	return show_menu || show_input_bindings_window || show_game_selection_window || show_rdp_conf_window;
+	return show_menu || show_input_bindings_window || show_game_selection_window || show_rdp_conf_window
+		|| show_frame_timing_window;
 }
 
 void Gui::OnCtrlKeyPress(SDL_Keycode keycode)
@@ -533,6 +679,16 @@ void Gui::OnInputBindingsWindowUseKeyboardDefaults()
 	// TODO
 }
 
+void Gui::OnMenuCaptureRdpCommands(bool capture)
+{
+	if (!capture) {
+		RDPCapture::Stop();
+	}
+	else if (!RDPCapture::Start(rdp_capture_path)) {
+		UserMessage::Error(std::format("Failed to open {} for writing", rdp_capture_path));
+	}
+}
+
 void Gui::OnMenuConfigureBindings()
 {
 	show_input_bindings_window = !show_input_bindings_window;
@@ -556,6 +712,11 @@ void Gui::OnMenuLoadState()
 	N64::LoadState();
 }
 
+void Gui::OnMenuLogCategory(Log::Category category, bool enabled)
+{
+	N64::SetLogCategoryEnabled(category, enabled);
+}
+
 void Gui::OnMenuOpen()
 {
 	std::optional<fs::path> path = FileDialog();
@@ -602,11 +763,48 @@ void Gui::OnMenuQuit()
 	OnSdlQuit();
 }
 
+void Gui::OnMenuRecordInputMovie()
+{
+	/* Movies are recorded from power-on, so that replaying them is deterministic */
+	if (!game_is_running) {
+		UserMessage::Error("Start a game before recording an input movie.");
+		return;
+	}
+	std::optional<fs::path> path = SaveFileDialog();
+	if (path.has_value()) {
+		StopGame();
+		if (N64::RecordInputMovie(path.value())) {
+			start_game = true;
+		}
+	}
+}
+
+void Gui::OnMenuReplayInputMovie()
+{
+	if (!game_is_running) {
+		UserMessage::Error("Start a game before replaying an input movie.");
+		return;
+	}
+	std::optional<fs::path> path = FileDialog();
+	if (path.has_value()) {
+		StopGame();
+		if (N64::ReplayInputMovie(path.value())) {
+			start_game = true;
+		}
+	}
+}
+
 void Gui::OnMenuReset()
 {
 	N64::Reset();
 }
 
+void Gui::OnMenuRunAhead(int frames)
+{
+	menu_run_ahead_frames = frames;
+	N64::SetRunAheadFrames(uint(frames));
+}
+
 void Gui::OnMenuSaveState()
 {
 	N64::SaveState();
@@ -622,6 +820,11 @@ void Gui::OnMenuStop()
 	StopGame();
 }
 
+void Gui::OnMenuStopInputMovie()
+{
+	N64::StopInputMovie();
+}
+
 void Gui::OnMenuWindowScale()
 {
 	// TODO
@@ -645,22 +848,7 @@ void Gui::PollEvents()
 {
 	static SDL_Event event{};
 	while (SDL_PollEvent(&event)) {
-		ImGui_ImplSDL2_ProcessEvent(&event);
-		switch (event.type) {
-		case SDL_AUDIODEVICEADDED       : Audio::OnDeviceAdded(event);             break;
-		case SDL_AUDIODEVICEREMOVED     : Audio::OnDeviceRemoved(event);           break;
-		case SDL_CONTROLLERAXISMOTION   : Input::OnControllerAxisMotion(event);    break;
-		case SDL_CONTROLLERBUTTONDOWN   : Input::OnControllerButtonDown(event);    break;
-		case SDL_CONTROLLERBUTTONUP     : Input::OnControllerButtonUp(event);      break;
-		case SDL_CONTROLLERDEVICEADDED  : Input::OnControllerDeviceAdded(event);   break;
-		case SDL_CONTROLLERDEVICEREMOVED: Input::OnControllerDeviceRemoved(event); break;
-		case SDL_KEYDOWN                : Input::OnKeyDown(event);                 break;
-		case SDL_KEYUP                  : Input::OnKeyUp(event);                   break;
-		case SDL_MOUSEBUTTONDOWN        : Input::OnMouseButtonDown(event);         break;
-		case SDL_MOUSEBUTTONUP          : Input::OnMouseButtonUp(event);           break;
-		case SDL_QUIT                   : OnSdlQuit();                             break;
-		case SDL_WINDOWEVENT_RESIZED    : OnWindowResizeEvent(event);              break;
-		}
+		HandleEvent(event);
 	}
 }
 
@@ -734,6 +922,7 @@ void Gui::StartGame()
 void Gui::StopGame()
 {
 	N64::Stop();
+	N64::StopInputMovie();
 	game_is_running = false;
 	UpdateWindowTitle();
 	show_game_selection_window = true;
@@ -6,6 +6,7 @@ module;
 
 export module Gui;
 
+import Log;
 import Util;
 
 import <algorithm>;
@@ -16,6 +17,7 @@ import <filesystem>;
 import <format>;
 import <iostream>;
 import <optional>;
+import <span>;
 import <string>;
 import <string_view>;
 import <unordered_map>;
@@ -37,7 +39,10 @@ namespace Gui
 
 	namespace fs = std::filesystem;
 
+	constexpr int max_run_ahead_frames = 4;
+
 	void Draw();
+	void DrawFrameTimingWindow();
 	void DrawGameSelectionWindow();
 	void DrawInputBindingsWindow();
 	void DrawMenu();
@@ -46,28 +51,36 @@ namespace Gui
 	bool ExitFullscreen();
 	std::optional<fs::path> FileDialog();
 	std::optional<fs::path> FolderDialog();
+	void HandleEvent(SDL_Event const& event);
 	bool InitGraphics();
 	bool InitImgui();
 	bool InitSdl();
+	void LatchInput();
 	bool NeedsDraw();
 	void OnGameSelected(size_t list_index);
 	void OnInputBindingsWindowResetAll();
 	void OnInputBindingsWindowSave();
 	void OnInputBindingsWindowUseControllerDefaults();
 	void OnInputBindingsWindowUseKeyboardDefaults();
+	void OnMenuCaptureRdpCommands(bool capture);
 	void OnMenuConfigureBindings();
 	void OnMenuEnableAudio();
 	void OnMenuFullscreen();
 	void OnMenuLoadState();
+	void OnMenuLogCategory(Log::Category category, bool enabled);
 	void OnMenuOpen();
 	void OnMenuOpenBios();
 	void OnMenuOpenRecent();
 	void OnMenuPause();
 	void OnMenuQuit();
+	void OnMenuRecordInputMovie();
+	void OnMenuReplayInputMovie();
 	void OnMenuReset();
+	void OnMenuRunAhead(int frames);
 	void OnMenuSaveState();
 	void OnMenuShowGameList();
 	void OnMenuStop();
+	void OnMenuStopInputMovie();
 	void OnMenuWindowScale();
 	void OnRdpWindowParallelRdpSelected();
 	void OnSdlQuit();
@@ -75,6 +88,7 @@ namespace Gui
 	void OnWindowResizeEvent(SDL_Event const& event);
 	bool ReadConfigFile();
 	void RefreshGameList();
+	std::optional<fs::path> SaveFileDialog();
 	void StartGame();
 	void StopGame();
 	void UpdateWindowTitle();
@@ -86,6 +100,7 @@ namespace Gui
 	bool menu_fullscreen;
 	bool menu_pause_emulation;
 	bool quit;
+	bool show_frame_timing_window;
 	bool show_game_selection_window;
 	bool show_input_bindings_window;
 	bool show_menu;
@@ -93,6 +108,7 @@ namespace Gui
 	bool start_game;
 
 	int frame_counter;
+	int menu_run_ahead_frames;
 	int window_height, window_width;
 
 	float fps;
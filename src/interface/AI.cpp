@@ -1,10 +1,11 @@
 module AI;
 
+import Audio;
 import BuildOptions;
 import Log;
 import MI;
-import Memory;
 import N64;
+import RDRAM;
 import Scheduler;
 import UserMessage;
 
@@ -15,10 +16,26 @@ namespace AI
 		ai = {};
 		dac = {};
 		ai.status = 1 << 20 | 1 << 24;
+		dma_in_progress = false;
 		dma_address_buffer = dma_count = dma_length_buffer = 0;
 	}
 
 
+	void OnDmaFinish()
+	{
+		dma_in_progress = false;
+		ai.dram_addr = (ai.dram_addr + ai.len) & 0xFF'FFF8;
+		ai.len = 0;
+		MI::SetInterruptFlag(MI::InterruptType::AI);
+		if (--dma_count > 0) {
+			ai.dram_addr = dma_address_buffer;
+			ai.len = dma_length_buffer;
+			StartDma();
+		}
+	}
+
+
+	template<bool log>
 	s32 ReadReg(u32 addr)
 	{
 		ai.status = 1 << 20 | 1 << 24;
@@ -29,8 +46,15 @@ namespace AI
 		static_assert(sizeof(ai) >> 2 == 8);
 		u32 offset = addr >> 2 & 7;
 		s32 ret;
-		std::memcpy(&ret, (s32*)(&ai) + offset, 4);
-		if constexpr (log_io_ai) {
+		if (offset == Register::Len && dma_in_progress) {
+			/* The whole buffer is handed to the host at once; derive the number of bytes the DAC has yet to consume. */
+			s64 cycles_until_finish = Scheduler::GetCyclesUntilEvent(Scheduler::EventType::AiDmaFinish);
+			ret = std::min(ai.len, u32(cycles_until_finish / std::max(1u, dac.period) * 4));
+		}
+		else {
+			std::memcpy(&ret, (s32*)(&ai) + offset, 4);
+		}
+		if constexpr (log) {
 			Log::IoRead("AI", RegOffsetToStr(offset), ret);
 		}
 		return ret;
@@ -51,30 +75,39 @@ namespace AI
 	}
 
 
-	void Sample()
+	void StartDma()
 	{
-		if (dma_count != 0) {
-			[[maybe_unused]] s32 data = Memory::Read<s32>(ai.dram_addr);
-			// TODO output sample
-			ai.dram_addr += 4;
-			ai.len -= 4;
-			if (ai.len == 0) {
-				MI::SetInterruptFlag(MI::InterruptType::AI);
-				if (--dma_count > 0) {
-					ai.dram_addr = dma_address_buffer;
-					ai.len = dma_length_buffer;
-				}
+		/* Precondition: dma_count > 0; ai.control & 1 */
+		/* Hand the whole buffer to the host at once, and only come back when the DAC would have consumed it. */
+		if (N64::IsAudioOutputEnabled()) {
+			size_t bytes_until_rdram_end = RDRAM::GetNumberOfBytesUntilMemoryEnd(ai.dram_addr);
+			size_t first_chunk_len = std::min(size_t(ai.len), bytes_until_rdram_end);
+			Audio::PushSamples(RDRAM::GetPointerToMemory(ai.dram_addr), first_chunk_len);
+			if (first_chunk_len < ai.len) {
+				Audio::PushSamples(RDRAM::GetPointerToMemory(0), ai.len - first_chunk_len);
 			}
 		}
-		Scheduler::AddEvent(Scheduler::EventType::AudioSample, dac.period, Sample);
+		if (Log::IsEnabled(Log::Category::Dma)) {
+			Log::Dma(std::format("From RDRAM ${:X} to AI: ${:X} bytes", ai.dram_addr, ai.len));
+		}
+		dma_in_progress = true;
+		s64 cycles_until_finish = s64(ai.len / 4) * dac.period;
+		Scheduler::AddEvent(Scheduler::EventType::AiDmaFinish, cycles_until_finish, OnDmaFinish);
 	}
 
 
+	void StreamState(Serializer& serializer)
+	{
+		serializer.Stream(ai, dac, dma_in_progress, dma_address_buffer, dma_count, dma_length_buffer);
+	}
+
+
+	template<bool log>
 	void WriteReg(u32 addr, s32 data)
 	{
 		static_assert(sizeof(ai) >> 2 == 8);
 		u32 offset = addr >> 2 & 7;
-		if constexpr (log_io_ai) {
+		if constexpr (log) {
 			Log::IoWrite("AI", RegOffsetToStr(offset), data);
 		}
 
@@ -89,7 +122,9 @@ namespace AI
 			s32 length = data & 0x3'FFF8;
 			if (dma_count < 2 && length > 0) {
 				dma_count == 0 ? ai.len = length : dma_length_buffer = length;
-				++dma_count;
+				if (++dma_count == 1 && ai.control) {
+					StartDma();
+				}
 			}
 			break;
 		}
@@ -99,10 +134,13 @@ namespace AI
 			ai.control = data & 1;
 			if (prev_control ^ ai.control) {
 				if (ai.control) {
-					Scheduler::AddEvent(Scheduler::EventType::AudioSample, dac.period, Sample);
+					if (dma_count > 0) {
+						StartDma();
+					}
 				}
 				else {
-					Scheduler::RemoveEvent(Scheduler::EventType::AudioSample);
+					Scheduler::RemoveEvent(Scheduler::EventType::AiDmaFinish);
+					dma_in_progress = false;
 				}
 			}
 		} break;
@@ -115,7 +153,10 @@ namespace AI
 			ai.dacrate = data & 0x3FFF;
 			dac.frequency = std::max(1u, N64::cpu_cycles_per_second / (ai.dacrate + 1));
 			dac.period = N64::cpu_cycles_per_second / dac.frequency;
-			Scheduler::ChangeEventTime(Scheduler::EventType::AudioSample, dac.period);
+			if (!N64::IsHeadless()) {
+				Audio::SetSampleRate(dac.frequency);
+			}
+			/* Takes effect from the next DMA, as the current buffer has already been handed to the host. */
 			break;
 
 		case Register::Bitrate:
@@ -126,4 +167,10 @@ namespace AI
 			Log::Warning(std::format("Unexpected write made to AI register at address ${:08X}", addr));
 		}
 	}
+
+
+	template s32 ReadReg<false>(u32);
+	template s32 ReadReg<true>(u32);
+	template void WriteReg<false>(u32, s32);
+	template void WriteReg<true>(u32, s32);
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 export module AI; /* Audio Interface */
 
+import Serializer;
 import Util;
 
+import <algorithm>;
 import <cstring>;
 import <format>;
 import <string_view>;
@@ -11,26 +13,29 @@ namespace AI
 	export
 	{
 		void Initialize();
-		s32 ReadReg(u32 addr);
-		void WriteReg(u32 addr, s32 data);
+		template<bool log> s32 ReadReg(u32 addr);
+		void StreamState(Serializer& serializer);
+		template<bool log> void WriteReg(u32 addr, s32 data);
 	}
 
 	enum Register {
 		DramAddr, Len, Control, Status, Dacrate, Bitrate
 	};
 
+	void OnDmaFinish();
 	constexpr std::string_view RegOffsetToStr(u32 reg_offset);
-	void Sample();
+	void StartDma();
 
-	struct Ai {
+	thread_local struct Ai {
 		u32 dram_addr, len, control, status, dacrate, bitrate, dummy0, dummy1;
 	} ai;
 
-	struct Dac {
+	thread_local struct Dac {
 		u32 frequency, period, precision;
 	} dac;
 
-	u32 dma_address_buffer;
-	u32 dma_count;
-	u32 dma_length_buffer;
+	thread_local bool dma_in_progress;
+	thread_local u32 dma_address_buffer;
+	thread_local u32 dma_count;
+	thread_local u32 dma_length_buffer;
 }
\ No newline at end of file
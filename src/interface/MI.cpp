@@ -31,13 +31,14 @@ namespace MI
 	}
 
 
+	template<bool log>
 	s32 ReadReg(u32 addr)
 	{
 		static_assert(sizeof(mi) >> 2 == 4);
 		u32 offset = addr >> 2 & 3;
 		s32 ret;
 		std::memcpy(&ret, (s32*)(&mi) + offset, 4);
-		if constexpr (log_io_mi) {
+		if constexpr (log) {
 			Log::IoRead("MI", RegOffsetToStr(offset), ret);
 		}
 		return ret;
@@ -63,11 +64,18 @@ namespace MI
 	}
 
 
+	void StreamState(Serializer& serializer)
+	{
+		serializer.Stream(mi);
+	}
+
+
+	template<bool log>
 	void WriteReg(u32 addr, s32 data)
 	{
 		static_assert(sizeof(mi) >> 2 == 4);
 		u32 offset = addr >> 2 & 3;
-		if constexpr (log_io_ai) {
+		if constexpr (log) {
 			Log::IoWrite("MI", RegOffsetToStr(offset), data);
 		}
 
@@ -140,4 +148,10 @@ namespace MI
 			CheckInterrupts();
 		}
 	}
+
+
+	template s32 ReadReg<false>(u32);
+	template s32 ReadReg<true>(u32);
+	template void WriteReg<false>(u32, s32);
+	template void WriteReg<true>(u32, s32);
 }
\ No newline at end of file
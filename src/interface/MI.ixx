@@ -1,5 +1,6 @@
 export module MI; /* MIPS Interface */
 
+import Serializer;
 import Util;
 
 import <cstring>;
@@ -21,9 +22,10 @@ namespace MI
 
 		void ClearInterruptFlag(InterruptType);
 		void Initialize();
-		s32 ReadReg(u32 addr);
+		template<bool log> s32 ReadReg(u32 addr);
 		void SetInterruptFlag(InterruptType);
-		void WriteReg(u32 addr, s32 data);
+		void StreamState(Serializer& serializer);
+		template<bool log> void WriteReg(u32 addr, s32 data);
 	}
 
 	enum Register {
@@ -33,7 +35,7 @@ namespace MI
 	void CheckInterrupts();
 	constexpr std::string_view RegOffsetToStr(u32 reg_offset);
 
-	struct Mi {
+	thread_local struct Mi {
 		s32 mode, version, interrupt, mask;
 	} mi;
 }
\ No newline at end of file
@@ -37,7 +37,7 @@ namespace PI
 			if (dma_len > num_bytes_first_block) {
 				std::memcpy(rdram_ptr + num_bytes_first_block, cart_ptr + num_bytes_first_block, dma_len - num_bytes_first_block);
 			}
-			if constexpr (log_dma) {
+			if (Log::IsEnabled(Log::Category::Dma)) {
 				Log::Dma(std::format("From cart ROM ${:X} to RDRAM ${:X}: ${:X} bytes",
 					pi.cart_addr, pi.dram_addr, dma_len));
 			}
@@ -47,7 +47,7 @@ namespace PI
 				I do not yet know the behavior */
 			//dma_len = std::min(dma_len, size_t(pi.rd_len + 1));
 			//std::memcpy(cart_ptr, rdram_ptr, dma_len);
-			//if constexpr (log_dma) {
+			//if (Log::IsEnabled(Log::Category::Dma)) {
 			//	LogDMA(std::format("From RDRAM ${:X} to cart ROM ${:X}: ${:X} bytes",
 			//		pi.dram_addr, pi.cart_addr, dma_len));
 			//}
@@ -78,13 +78,14 @@ namespace PI
 	}
 
 
+	template<bool log>
 	s32 ReadReg(u32 addr)
 	{
 		static_assert(sizeof(pi) >> 2 == 0x10);
 		u32 offset = addr >> 2 & 0xF;
 		s32 ret;
 		std::memcpy(&ret, (s32*)(&pi) + offset, 4);
-		if constexpr (log_io_ai) {
+		if constexpr (log) {
 			Log::IoRead("PI", RegOffsetToStr(offset), ret);
 		}
 		return ret;
@@ -118,11 +119,18 @@ namespace PI
 	}
 
 
+	void StreamState(Serializer& serializer)
+	{
+		serializer.Stream(pi, dma_len);
+	}
+
+
+	template<bool log>
 	void WriteReg(u32 addr, s32 data)
 	{
 		static_assert(sizeof(pi) >> 2 == 0x10);
 		u32 offset = addr >> 2 & 0xF;
-		if constexpr (log_io_ai) {
+		if constexpr (log) {
 			Log::IoWrite("PI", RegOffsetToStr(offset), data);
 		}
 
@@ -174,4 +182,10 @@ namespace PI
 			Log::Warning(std::format("Unexpected write made to PI register at address ${:08X}", addr));
 		}
 	}
+
+
+	template s32 ReadReg<false>(u32);
+	template s32 ReadReg<true>(u32);
+	template void WriteReg<false>(u32, s32);
+	template void WriteReg<true>(u32, s32);
 }
\ No newline at end of file
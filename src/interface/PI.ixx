@@ -1,5 +1,6 @@
 export module PI; /* Peripheral Interface */
 
+import Serializer;
 import Util;
 
 import <algorithm>;
@@ -21,9 +22,10 @@ namespace PI
 
 		void ClearStatusFlag(StatusFlag);
 		void Initialize();
-		s32 ReadReg(u32 addr);
+		template<bool log> s32 ReadReg(u32 addr);
 		void SetStatusFlag(StatusFlag);
-		void WriteReg(u32 addr, s32 data);
+		void StreamState(Serializer& serializer);
+		template<bool log> void WriteReg(u32 addr, s32 data);
 	}
 
 	enum class DmaType {
@@ -41,12 +43,12 @@ namespace PI
 
 	constexpr std::string_view RegOffsetToStr(u32 reg_offset);
 
-	struct Pi {
+	thread_local struct Pi {
 		s32 dram_addr, cart_addr, rd_len, wr_len, status;
 		s32 bsd_dom1_lat, bsd_dom1_pwd, bsd_dom1_pgs, bsd_dom1_rls;
 		s32 bsd_dom2_lat, bsd_dom2_pwd, bsd_dom2_pgs, bsd_dom2_rls;
 		s32 dummy0, dummy1, dummy2;
 	} pi;
 
-	size_t dma_len;
+	thread_local size_t dma_len;
 }
\ No newline at end of file
@@ -37,7 +37,7 @@ namespace SI
 		if constexpr (type == DmaType::PifToRdram) {
 			u8* pif_ptr = PIF::GetPointerToMemory(pif_addr);
 			std::memcpy(rdram_ptr, pif_ptr, dma_len);
-			if constexpr (log_dma) {
+			if (Log::IsEnabled(Log::Category::Dma)) {
 				Log::Dma(std::format("From PIF ${:X} to RDRAM ${:X}: ${:X} bytes",
 					pif_addr, si.dram_addr, dma_len));
 			}
@@ -55,7 +55,7 @@ namespace SI
 					pif_addr += 4;
 					rdram_ptr += 4;
 				}
-				if constexpr (log_dma) {
+				if (Log::IsEnabled(Log::Category::Dma)) {
 					Log::Dma(std::format("From RDRAM ${:X} to PIF ${:X}: ${:X} bytes",
 						si.dram_addr, pif_addr, dma_len - num_bytes_in_rom_area));
 				}
@@ -90,13 +90,14 @@ namespace SI
 	}
 
 
+	template<bool log>
 	s32 ReadReg(u32 addr)
 	{
 		static_assert(sizeof(si) >> 2 == 8);
 		u32 offset = addr >> 2 & 7;
 		s32 ret;
 		std::memcpy(&ret, (s32*)(&si) + offset, 4);
-		if constexpr (log_io_si) {
+		if constexpr (log) {
 			Log::IoRead("SI", RegOffsetToStr(offset), ret);
 		}
 		return ret;
@@ -123,11 +124,18 @@ namespace SI
 	}
 
 
+	void StreamState(Serializer& serializer)
+	{
+		serializer.Stream(si, dma_len, pif_addr_reg_last_dma);
+	}
+
+
+	template<bool log>
 	void WriteReg(u32 addr, s32 data)
 	{
 		static_assert(sizeof(si) >> 2 == 8);
 		u32 offset = addr >> 2 & 7;
-		if constexpr (log_io_ai) {
+		if constexpr (log) {
 			Log::IoWrite("SI", RegOffsetToStr(offset), data);
 		}
 
@@ -170,4 +178,10 @@ namespace SI
 			Log::Warning(std::format("Unexpected write made to SI register at address ${:08X}", addr));
 		}
 	}
+
+
+	template s32 ReadReg<false>(u32);
+	template s32 ReadReg<true>(u32);
+	template void WriteReg<false>(u32, s32);
+	template void WriteReg<true>(u32, s32);
 }
\ No newline at end of file
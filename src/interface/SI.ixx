@@ -1,5 +1,6 @@
 export module SI; /* Serial Interface */
 
+import Serializer;
 import Util;
 
 import <cstring>;
@@ -21,9 +22,10 @@ namespace SI
 
 		void ClearStatusFlag(StatusFlag);
 		void Initialize();
-		s32 ReadReg(u32 addr);
+		template<bool log> s32 ReadReg(u32 addr);
 		void SetStatusFlag(StatusFlag);
-		void WriteReg(u32 addr, s32 data);
+		void StreamState(Serializer& serializer);
+		template<bool log> void WriteReg(u32 addr, s32 data);
 	}
 
 	enum class DmaType {
@@ -39,11 +41,11 @@ namespace SI
 	void OnDmaFinish();
 	constexpr std::string_view RegOffsetToStr(u32 reg_offset);
 
-	struct Si {
+	thread_local struct Si {
 		s32 dram_addr, pif_addr_rd64b, pif_addr_wr4b, dummy0,
 			pif_addr_wr64b, pif_addr_rd4b, status, dummy1;
 	} si;
 
-	size_t dma_len;
-	s32* pif_addr_reg_last_dma;
+	thread_local size_t dma_len;
+	thread_local s32* pif_addr_reg_last_dma;
 }
\ No newline at end of file
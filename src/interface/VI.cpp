@@ -1,6 +1,7 @@
 module VI;
 
 import BuildOptions;
+import FrameTiming;
 import Log;
 import MI;
 import N64;
@@ -11,17 +12,32 @@ namespace VI
 {
 	void AddInitialEvents()
 	{
-		Scheduler::AddEvent(Scheduler::EventType::VINewHalfline, cpu_cycles_per_halfline, OnNewHalflineEvent);
+		field_start_time = Scheduler::GetGlobalTime();
+		field_v_current_start = vi.v_current;
+		ScheduleEvents();
 	}
 
 
-	void CheckVideoInterrupt()
+	u64 GetCurrentHalfline()
 	{
-		bool prev_interrupt = interrupt;
-		interrupt = vi.v_current == vi.v_intr;
-		if (interrupt && !prev_interrupt) {
-			MI::SetInterruptFlag(MI::InterruptType::VI);
+		/* The number of halflines since the start of the current field. Capped to the last halfline of the field,
+		   in case the field has ended but the scheduler has not gotten around to firing the event yet. */
+		u64 now = Scheduler::GetGlobalTime();
+		if (now < field_start_time) {
+			return 0;
+		}
+		u64 halfline = (now - field_start_time) / cpu_cycles_per_halfline;
+		return std::min(halfline, u64(GetNumHalflinesInField() - 1));
+	}
+
+
+	u32 GetNumHalflinesInField()
+	{
+		/* The field ends at the first halfline at which v_current >= v_sync */
+		if (field_v_current_start >= vi.v_sync) {
+			return 1;
 		}
+		return (vi.v_sync - field_v_current_start + 1) / 2;
 	}
 
 
@@ -35,7 +51,8 @@ namespace VI
 		vi.v_sync = default_vsync_ntsc; /* todo: pal */
 		vi.h_sync = 0x15'07FF;
 		cpu_cycles_per_halfline = N64::cpu_cycles_per_frame / (vi.v_sync >> 1);
-		Scheduler::ChangeEventTime(Scheduler::EventType::VINewHalfline, cpu_cycles_per_halfline);
+		field_v_current_start = 0;
+		field_start_time = 0;
 	}
 
 
@@ -45,32 +62,49 @@ namespace VI
 	}
 
 
-	void OnNewHalflineEvent()
+	void OnNewFieldEvent()
 	{
-		vi.v_current += 2;
-		if (vi.v_current >= vi.v_sync) {
-			u32 field = vi.v_current & 1;
-			vi.v_current = (field ^ 1) & u32(Interlaced());
+		u32 field = field_v_current_start & 1; /* v_current advances in steps of two, so this is the parity at the end of the field */
+		field_start_time += u64(GetNumHalflinesInField()) * cpu_cycles_per_halfline;
+		field_v_current_start = (field ^ 1) & u32(Interlaced());
+		if (RDP::implementation && N64::IsVideoOutputEnabled()) {
+			FrameTiming::Scope timing_scope{ FrameTiming::Unit::Present };
 			RDP::implementation->UpdateScreen();
 		}
-		CheckVideoInterrupt();
-		Scheduler::AddEvent(Scheduler::EventType::VINewHalfline, cpu_cycles_per_halfline, OnNewHalflineEvent);
+		if constexpr (time_subsystems) {
+			FrameTiming::EndFrame();
+		}
+		if (vi.v_intr == field_v_current_start) {
+			MI::SetInterruptFlag(MI::InterruptType::VI);
+		}
+		ScheduleEvents();
+	}
+
+
+	void OnVideoInterruptEvent()
+	{
+		MI::SetInterruptFlag(MI::InterruptType::VI);
 	}
 
 
 	const Registers& ReadAllRegisters()
 	{
+		UpdateVCurrent();
 		return vi;
 	}
 
 
+	template<bool log>
 	s32 ReadReg(u32 addr)
 	{
 		static_assert(sizeof(vi) >> 2 == 0x10);
 		u32 offset = addr >> 2 & 0xF;
+		if (offset == Register::VCurrent) {
+			UpdateVCurrent();
+		}
 		s32 ret;
 		std::memcpy(&ret, (s32*)(&vi) + offset, 4);
-		if constexpr (log_io_ai) {
+		if constexpr (log) {
 			Log::IoRead("VI", RegOffsetToStr(offset), ret);
 		}
 		return ret;
@@ -101,11 +135,42 @@ namespace VI
 	}
 
 
+	void ScheduleEvents()
+	{
+		/* Only two events are needed per field; one for when v_current reaches v_intr, and one for the end of the field. */
+		Scheduler::RemoveEvent(Scheduler::EventType::VIInterrupt);
+		Scheduler::RemoveEvent(Scheduler::EventType::VINewField);
+		u64 now = Scheduler::GetGlobalTime();
+		u64 field_end_time = field_start_time + u64(GetNumHalflinesInField()) * cpu_cycles_per_halfline;
+		Scheduler::AddEvent(Scheduler::EventType::VINewField, s64(field_end_time) - s64(now), OnNewFieldEvent);
+		if (vi.v_intr >= field_v_current_start && ((vi.v_intr - field_v_current_start) & 1) == 0) {
+			u64 intr_halfline = (vi.v_intr - field_v_current_start) / 2;
+			if (intr_halfline > GetCurrentHalfline() && intr_halfline < GetNumHalflinesInField()) {
+				u64 intr_time = field_start_time + intr_halfline * cpu_cycles_per_halfline;
+				Scheduler::AddEvent(Scheduler::EventType::VIInterrupt, s64(intr_time) - s64(now), OnVideoInterruptEvent);
+			}
+		}
+	}
+
+
+	void StreamState(Serializer& serializer)
+	{
+		serializer.Stream(vi, cpu_cycles_per_halfline, field_v_current_start, field_start_time);
+	}
+
+
+	void UpdateVCurrent()
+	{
+		vi.v_current = field_v_current_start + 2 * u32(GetCurrentHalfline());
+	}
+
+
+	template<bool log>
 	void WriteReg(u32 addr, s32 data)
 	{
 		static_assert(sizeof(vi) >> 2 == 0x10);
 		u32 offset = addr >> 2 & 0xF;
-		if constexpr (log_io_ai) {
+		if constexpr (log) {
 			Log::IoWrite("VI", RegOffsetToStr(offset), data);
 		}
 
@@ -122,10 +187,15 @@ namespace VI
 			vi.width = data & 0xFFF;
 			break;
 
-		case Register::VIntr:
+		case Register::VIntr: {
+			u32 prev_v_intr = vi.v_intr;
 			vi.v_intr = data & 0x3FF;
-			CheckVideoInterrupt();
-			break;
+			UpdateVCurrent();
+			if (vi.v_intr != prev_v_intr && vi.v_intr == vi.v_current) {
+				MI::SetInterruptFlag(MI::InterruptType::VI);
+			}
+			ScheduleEvents();
+		} break;
 
 		case Register::VCurrent:
 			MI::ClearInterruptFlag(MI::InterruptType::VI);
@@ -135,11 +205,15 @@ namespace VI
 			vi.burst = data & 0x3FFF'FFFF;
 			break;
 
-		case Register::VSync:
+		case Register::VSync: {
+			/* Rebase the field on the current halfline, so that v_current carries on from where it is. */
+			u64 current_halfline = GetCurrentHalfline();
+			field_v_current_start += 2 * u32(current_halfline);
+			field_start_time += current_halfline * cpu_cycles_per_halfline;
 			vi.v_sync = data & 0x3FF ? data & 0x3FF : default_vsync_ntsc; /* todo: pal */
 			cpu_cycles_per_halfline = N64::cpu_cycles_per_frame / (vi.v_sync >> 1);
-			Scheduler::ChangeEventTime(Scheduler::EventType::VINewHalfline, cpu_cycles_per_halfline);
-			break;
+			ScheduleEvents();
+		} break;
 
 		case Register::HSync:
 			vi.h_sync = data & 0x1F'0FFF;
@@ -181,4 +255,10 @@ namespace VI
 			std::unreachable();
 		}
 	}
+
+
+	template s32 ReadReg<false>(u32);
+	template s32 ReadReg<true>(u32);
+	template void WriteReg<false>(u32, s32);
+	template void WriteReg<true>(u32, s32);
 }
\ No newline at end of file
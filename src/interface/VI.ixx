@@ -1,7 +1,9 @@
 export module VI; /* Video Interface */
 
+import Serializer;
 import Util;
 
+import <algorithm>;
 import <bit>;
 import <cstring>;
 import <string_view>;
@@ -25,19 +27,27 @@ namespace VI
 		void AddInitialEvents();
 		void Initialize();
 		const Registers& ReadAllRegisters();
-		s32 ReadReg(u32 addr);
-		void WriteReg(u32 addr, s32 data);
+		template<bool log> s32 ReadReg(u32 addr);
+		void StreamState(Serializer& serializer);
+		template<bool log> void WriteReg(u32 addr, s32 data);
 	}
 
-	void CheckVideoInterrupt();
+	u64 GetCurrentHalfline();
+	u32 GetNumHalflinesInField();
 	bool Interlaced();
-	void OnNewHalflineEvent();
+	void OnNewFieldEvent();
+	void OnVideoInterruptEvent();
 	constexpr std::string_view RegOffsetToStr(u32 reg_offset);
+	void ScheduleEvents();
+	void UpdateVCurrent();
 
 	constexpr u32 default_vsync_ntsc = 0x20D;
 
-	Registers vi;
+	thread_local Registers vi;
 
-	bool interrupt;
-	u32 cpu_cycles_per_halfline;
+	/* VI_V_CURRENT is not stepped every halfline, but derived from the global time when read.
+	   Within a field, v_current == field_v_current_start + 2 * (number of halflines since field_start_time). */
+	thread_local u32 cpu_cycles_per_halfline;
+	thread_local u32 field_v_current_start;
+	thread_local u64 field_start_time;
 }
\ No newline at end of file
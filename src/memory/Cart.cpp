@@ -1,3 +1,15 @@
+module;
+
+#ifdef _WIN64
+#include <intrin.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 module Cart;
 
 import UserMessage;
@@ -11,6 +23,27 @@ namespace Cart
 	}
 
 
+	template<size_t word_size>
+	void ByteswapRom()
+	{
+		static_assert(word_size == 2 || word_size == 4);
+		/* Reverses the order of the bytes within each 16-bit or 32-bit word */
+		__m128i shuffle_mask = word_size == 2
+			? _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1)
+			: _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+		size_t i = 0;
+		if (HostHasSsse3()) {
+			for (; i + 16 <= original_rom_size; i += 16) {
+				__m128i data = _mm_loadu_si128((__m128i*)(rom + i));
+				_mm_storeu_si128((__m128i*)(rom + i), _mm_shuffle_epi8(data, shuffle_mask));
+			}
+		}
+		for (; i + word_size <= original_rom_size; i += word_size) {
+			std::reverse(rom + i, rom + i + word_size);
+		}
+	}
+
+
 	size_t GetNumberOfBytesUntilRomEnd(u32 addr)
 	{
 		static constexpr u32 addr_rom_start = 0x1000'0000;
@@ -20,7 +53,7 @@ namespace Cart
 
 	u8* GetPointerToRom(u32 addr)
 	{
-		return rom.empty() ? nullptr : rom.data() + (addr & rom_access_mask);
+		return rom ? rom + (addr & rom_access_mask) : nullptr;
 	}
 
 
@@ -30,26 +63,57 @@ namespace Cart
 	}
 
 
-	bool LoadRom(const std::filesystem::path& rom_path)
+	u64 GetRomHash()
 	{
-		std::optional<std::vector<u8>> optional_rom = ReadFileIntoVector(rom_path);
-		if (!optional_rom.has_value()) {
-			UserMessage::Error("Failed to open rom file.");
-			return false;
+		/* Hashed on first use, as hashing touches every page of the rom file mapping */
+		if (!rom_hash.has_value()) {
+			rom_hash = HashRom();
 		}
-		rom = optional_rom.value();
-		if (rom.empty()) {
-			UserMessage::Error("Rom file has size 0.");
-			return false;
+		return rom_hash.value();
+	}
+
+
+	u64 HashRom()
+	{
+		/* FNV-1a, one 64-bit word at a time */
+		static constexpr u64 fnv_offset_basis = 0xCBF2'9CE4'8422'2325;
+		static constexpr u64 fnv_prime = 0x100'0000'01B3;
+		u64 hash = fnv_offset_basis;
+		size_t i = 0;
+		for (; i + 8 <= original_rom_size; i += 8) {
+			u64 word;
+			std::memcpy(&word, rom + i, 8);
+			hash = (hash ^ word) * fnv_prime;
 		}
-		if (rom.size() > rom_region_size) {
-			UserMessage::Warning(std::format("Rom file has size larger than the maximum allowed ({} bytes). "
-				"Truncating to the maximum allowed.", rom_region_size));
-			rom.resize(rom_region_size);
+		for (; i < original_rom_size; ++i) {
+			hash = (hash ^ rom[i]) * fnv_prime;
 		}
-		original_rom_size = rom.size();
-		ResizeRomToPowerOfTwo();
-		rom_access_mask = u32(rom.size() - 1);
+		return hash;
+	}
+
+
+	bool HostHasSsse3()
+	{
+		/* for pshufb in ByteswapRom */
+#ifdef _WIN64
+		int cpu_info[4];
+		__cpuid(cpu_info, 1);
+		return cpu_info[2] & 1 << 9;
+#else
+		return __builtin_cpu_supports("ssse3");
+#endif
+	}
+
+
+	bool LoadRom(const std::filesystem::path& rom_path)
+	{
+		UnmapRom();
+		if (!MapRomFile(rom_path)) {
+			return false;
+		}
+		NormalizeRomByteOrder();
+		MirrorRomToPowerOfTwo();
+		rom_access_mask = u32(rom_size - 1);
 		AllocateSram();
 		return true;
 	}
@@ -74,6 +138,141 @@ namespace Cart
 	}
 
 
+	bool MapRomFile(const std::filesystem::path& rom_path)
+	{
+		/* Reserves a power-of-two sized window for the rom, with the rom file mapped copy-on-write at its start,
+		   so that the rom can be byteswapped in place and mirrored without reading it into a buffer first. */
+#ifdef _WIN64
+		HANDLE file = CreateFileW(rom_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			UserMessage::Error("Failed to open rom file.");
+			return false;
+		}
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size)) {
+			UserMessage::Error(std::format("GetFileSizeEx failed with error code {}", GetLastError()));
+			CloseHandle(file);
+			return false;
+		}
+		size_t size = size_t(file_size.QuadPart);
+#else
+		int fd = open(rom_path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			UserMessage::Error("Failed to open rom file.");
+			return false;
+		}
+		struct stat file_stat;
+		if (fstat(fd, &file_stat) == -1) {
+			UserMessage::Error("fstat failed on rom file.");
+			close(fd);
+			return false;
+		}
+		size_t size = size_t(file_stat.st_size);
+#endif
+		if (size == 0) {
+			UserMessage::Error("Rom file has size 0.");
+#ifdef _WIN64
+			CloseHandle(file);
+#else
+			close(fd);
+#endif
+			return false;
+		}
+		if (size > rom_region_size) {
+			UserMessage::Warning(std::format("Rom file has size larger than the maximum allowed ({} bytes). "
+				"Truncating to the maximum allowed.", rom_region_size));
+			size = rom_region_size;
+		}
+		original_rom_size = u32(size);
+		rom_size = std::bit_ceil(size);
+
+#ifdef _WIN64
+		/* Mapping a second view of the file right after the first one, for the mirror, requires placeholder
+		   support (VirtualAlloc2/MapViewOfFile3). Only map the file if no mirroring is needed, else read it. */
+		if (rom_size == original_rom_size) {
+			HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (mapping) {
+				rom = (u8*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, rom_size);
+				CloseHandle(mapping); /* the view keeps the mapping alive */
+			}
+			rom_is_file_view = rom != nullptr;
+		}
+		if (!rom) {
+			rom = (u8*)VirtualAlloc(nullptr, rom_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+			if (!rom) {
+				UserMessage::Error(std::format("VirtualAlloc failed with error code {}", GetLastError()));
+				CloseHandle(file);
+				return false;
+			}
+			for (size_t bytes_read = 0; bytes_read < original_rom_size; ) {
+				DWORD chunk_size = DWORD((std::min)(original_rom_size - bytes_read, size_t(1) << 30));
+				DWORD chunk_bytes_read;
+				if (!ReadFile(file, rom + bytes_read, chunk_size, &chunk_bytes_read, nullptr) || chunk_bytes_read == 0) {
+					UserMessage::Error("Failed to read rom file.");
+					CloseHandle(file);
+					UnmapRom();
+					return false;
+				}
+				bytes_read += chunk_bytes_read;
+			}
+		}
+		CloseHandle(file);
+#else
+		void* window = mmap(nullptr, rom_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (window == MAP_FAILED) {
+			UserMessage::Error("Failed to reserve memory for the rom.");
+			close(fd);
+			return false;
+		}
+		if (mmap(window, original_rom_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+			UserMessage::Error("Failed to map rom file.");
+			munmap(window, rom_size);
+			close(fd);
+			return false;
+		}
+		rom = (u8*)window;
+		/* If the rom is already big-endian, the mirror can be a second view of the file, provided it starts on a page boundary.
+		   The file descriptor is kept open until then; the mappings themselves do not need it. */
+		if (original_rom_size != rom_size && original_rom_size % sysconf(_SC_PAGESIZE) == 0
+			&& std::memcmp(rom, z64_header_magic.data(), z64_header_magic.size()) == 0) {
+			if (mmap(rom + original_rom_size, rom_size - original_rom_size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED) {
+				rom_mirror_is_mapped = true;
+			}
+		}
+		close(fd);
+#endif
+		return true;
+	}
+
+
+	void MirrorRomToPowerOfTwo()
+	{
+		/* Accesses past the end of the rom wrap around to its start */
+		if (!rom_mirror_is_mapped) {
+			std::memcpy(rom + original_rom_size, rom, rom_size - original_rom_size);
+		}
+	}
+
+
+	void NormalizeRomByteOrder()
+	{
+		if (original_rom_size < 4 || std::memcmp(rom, z64_header_magic.data(), z64_header_magic.size()) == 0) {
+			return;
+		}
+		if (std::memcmp(rom, v64_header_magic.data(), v64_header_magic.size()) == 0) {
+			ByteswapRom<2>();
+		}
+		else if (std::memcmp(rom, n64_header_magic.data(), n64_header_magic.size()) == 0) {
+			ByteswapRom<4>();
+		}
+		else {
+			UserMessage::Warning("Could not determine the byte order of the rom from its header. Assuming big-endian.");
+		}
+	}
+
+
 	template<std::signed_integral Int>
 	Int ReadRom(u32 addr)
 	{
@@ -98,15 +297,30 @@ namespace Cart
 	}
 
 
-	void ResizeRomToPowerOfTwo()
+	void StreamState(Serializer& serializer)
 	{
-		size_t actual_size = rom.size();
-		size_t pow_two_size = std::bit_ceil(actual_size);
-		size_t diff = pow_two_size - actual_size;
-		if (diff > 0) {
-			rom.resize(pow_two_size);
-			std::copy(rom.begin(), rom.begin() + diff, rom.begin() + actual_size);
+		serializer.Stream(sram);
+	}
+
+
+	void UnmapRom()
+	{
+		if (!rom) {
+			return;
+		}
+#ifdef _WIN64
+		if (rom_is_file_view) {
+			UnmapViewOfFile(rom);
+		}
+		else {
+			VirtualFree(rom, 0, MEM_RELEASE);
 		}
+#else
+		munmap(rom, rom_size);
+#endif
+		rom = nullptr;
+		rom_is_file_view = rom_mirror_is_mapped = false;
+		rom_hash.reset();
 	}
 
 
@@ -1,8 +1,10 @@
 export module Cart;
 
+import Serializer;
 import Util;
 
 import <algorithm>;
+import <array>;
 import <bit>;
 import <cassert>;
 import <concepts>;
@@ -13,6 +15,9 @@ import <optional>;
 import <string>;
 import <vector>;
 
+import <emmintrin.h>;
+import <tmmintrin.h>;
+
 namespace Cart
 {
 	export
@@ -20,8 +25,10 @@ namespace Cart
 		size_t GetNumberOfBytesUntilRomEnd(u32 addr);
 		u8* GetPointerToRom(u32 addr);
 		u8* GetPointerToSram(u32 addr);
+		u64 GetRomHash();
 		bool LoadRom(const std::filesystem::path& rom_path);
 		bool LoadSram(const std::filesystem::path& sram_path);
+		void StreamState(Serializer& serializer);
 
 		template<std::signed_integral Int>
 		Int ReadRom(u32 addr);
@@ -37,14 +44,29 @@ namespace Cart
 	}
 
 	void AllocateSram();
-	void ResizeRomToPowerOfTwo();
+	template<size_t word_size> void ByteswapRom();
+	u64 HashRom();
+	bool HostHasSsse3();
+	bool MapRomFile(const std::filesystem::path& rom_path);
+	void MirrorRomToPowerOfTwo();
+	void NormalizeRomByteOrder();
+	void UnmapRom();
 
 	constexpr size_t rom_region_size = 0x0FC0'0000;
 	constexpr size_t sram_size = 0x10000; 
 
-	u32 original_rom_size;
-	u32 rom_access_mask;
+	/* The first word of the rom header, in the byte orders of .z64 (big-endian), .v64 (byte-swapped) and .n64 (little-endian) images */
+	constexpr std::array<u8, 4> z64_header_magic = { 0x80, 0x37, 0x12, 0x40 };
+	constexpr std::array<u8, 4> v64_header_magic = { 0x37, 0x80, 0x40, 0x12 };
+	constexpr std::array<u8, 4> n64_header_magic = { 0x40, 0x12, 0x37, 0x80 };
+
+	thread_local bool rom_is_file_view; /* Windows: whether 'rom' is a copy-on-write view of the rom file, or memory allocated and filled by us */
+	thread_local bool rom_mirror_is_mapped; /* whether the region past the end of the rom is a second view of the rom file, rather than a copy */
+	thread_local u32 original_rom_size;
+	thread_local u32 rom_access_mask;
+	thread_local std::optional<u64> rom_hash; /* of the rom contents in big-endian byte order; identifies the game in on-disk caches */
+	thread_local size_t rom_size; /* size of the memory pointed to by 'rom'; 'original_rom_size' rounded up to a power of two */
 
-	std::vector<u8> sram;
-	std::vector<u8> rom;
+	thread_local std::vector<u8> sram;
+	thread_local u8* rom;
 }
\ No newline at end of file
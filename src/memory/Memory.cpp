@@ -16,9 +16,9 @@ import VI;
 
 namespace Memory
 {
-#define READ_INTERFACE(io, INT, addr) [&] {                                    \
+#define READ_INTERFACE(read_reg, INT, addr) [&] {                              \
 	if constexpr (sizeof(INT) == 4) {                                          \
-		return io::ReadReg(addr);                                              \
+		return read_reg(addr);                                                 \
 	}                                                                          \
 	else {                                                                     \
 		Log::Warning(std::format(                                              \
@@ -28,9 +28,9 @@ namespace Memory
 	}}()
 
 
-#define WRITE_INTERFACE(io, access_size, addr, data)                            \
+#define WRITE_INTERFACE(write_reg, access_size, addr, data)                     \
 	if constexpr (access_size == 4) {                                           \
-		io::WriteReg(addr, data);                                               \
+		write_reg(addr, data);                                                  \
 	}                                                                           \
 	else {                                                                      \
 		Log::Warning(std::format(                                               \
@@ -48,35 +48,35 @@ namespace Memory
 		if (addr <= 0x048F'FFFF) {
 			switch ((addr >> 20) - 0x3F) {
 			case 0: /* $03F0'0000 - $03FF'FFFF */
-				return READ_INTERFACE(RDRAM, Int, addr);
+				return READ_INTERFACE(RDRAM::ReadReg, Int, addr);
 
 			case 1: /* $0400'0000 - $040F'FFFF */
 				return RSP::ReadMemoryCpu<Int>(addr);
 
 			case 2: /* $0410'0000 - $041F'FFFF */
-				return READ_INTERFACE(RDP, Int, addr);
+				return READ_INTERFACE(rdp_io.read_reg, Int, addr);
 
 			case 3: /* $0420'0000 - $042F'FFFF */
 				Log::Warning(std::format("Unexpected cpu read to address ${:08X}", addr));
 				return Int{};
 
 			case 4: /* $0430'0000 - $043F'FFFF */
-				return READ_INTERFACE(MI, Int, addr);
+				return READ_INTERFACE(mi_io.read_reg, Int, addr);
 
 			case 5: /* $0440'0000 - $044F'FFFF */
-				return READ_INTERFACE(VI, Int, addr);
+				return READ_INTERFACE(vi_io.read_reg, Int, addr);
 
 			case 6: /* $0450'0000 - $045F'FFFF */
-				return READ_INTERFACE(AI, Int, addr);
+				return READ_INTERFACE(ai_io.read_reg, Int, addr);
 
 			case 7: /* $0460'0000 - $046F'FFFF */
-				return READ_INTERFACE(PI, Int, addr);
+				return READ_INTERFACE(pi_io.read_reg, Int, addr);
 
 			case 8: /* $0470'0000 - $047F'FFFF */
-				return READ_INTERFACE(RI, Int, addr);
+				return READ_INTERFACE(RI::ReadReg, Int, addr);
 
 			case 9: /* $0480'0000 - $048F'FFFF */
-				return READ_INTERFACE(SI, Int, addr);
+				return READ_INTERFACE(si_io.read_reg, Int, addr);
 
 			default:
 				std::unreachable();
@@ -96,6 +96,20 @@ namespace Memory
 	}
 
 
+	void SetActiveIoFunctions()
+	{
+		auto Select = [](Log::Category category, IoFunctions with_log, IoFunctions without_log) {
+			return Log::IsEnabled(category) ? with_log : without_log;
+		};
+		ai_io = Select(Log::Category::IoAi, { AI::ReadReg<true>, AI::WriteReg<true> }, { AI::ReadReg<false>, AI::WriteReg<false> });
+		mi_io = Select(Log::Category::IoMi, { MI::ReadReg<true>, MI::WriteReg<true> }, { MI::ReadReg<false>, MI::WriteReg<false> });
+		pi_io = Select(Log::Category::IoPi, { PI::ReadReg<true>, PI::WriteReg<true> }, { PI::ReadReg<false>, PI::WriteReg<false> });
+		rdp_io = Select(Log::Category::IoRdp, { RDP::ReadReg<true>, RDP::WriteReg<true> }, { RDP::ReadReg<false>, RDP::WriteReg<false> });
+		si_io = Select(Log::Category::IoSi, { SI::ReadReg<true>, SI::WriteReg<true> }, { SI::ReadReg<false>, SI::WriteReg<false> });
+		vi_io = Select(Log::Category::IoVi, { VI::ReadReg<true>, VI::WriteReg<true> }, { VI::ReadReg<false>, VI::WriteReg<false> });
+	}
+
+
 	template<size_t access_size, typename... MaskT>
 	void Write(u32 addr, s64 data, MaskT... mask)
 	{
@@ -107,34 +121,34 @@ namespace Memory
 		else if (addr <= 0x048F'FFFF) {
 			switch ((addr >> 20) - 0x3F) {
 			case 0: /* $03F0'0000 - $03FF'FFFF */
-				WRITE_INTERFACE(RDRAM, access_size, addr, data); break;
+				WRITE_INTERFACE(RDRAM::WriteReg, access_size, addr, data); break;
 
 			case 1: /* $0400'0000 - $040F'FFFF */
 				RSP::WriteMemoryCpu<access_size>(addr, data); break;
 
 			case 2: /* $0410'0000 - $041F'FFFF */
-				WRITE_INTERFACE(RDP, access_size, addr, data); break;
+				WRITE_INTERFACE(rdp_io.write_reg, access_size, addr, data); break;
 
 			case 3: /* $0420'0000 - $042F'FFFF */
 				Log::Warning(std::format("Unexpected cpu write to address ${:08X}", addr)); break;
 
 			case 4: /* $0430'0000 - $043F'FFFF */
-				WRITE_INTERFACE(MI, access_size, addr, data); break;
+				WRITE_INTERFACE(mi_io.write_reg, access_size, addr, data); break;
 
 			case 5: /* $0440'0000 - $044F'FFFF */
-				WRITE_INTERFACE(VI, access_size, addr, data); break;
+				WRITE_INTERFACE(vi_io.write_reg, access_size, addr, data); break;
 
 			case 6: /* $0450'0000 - $045F'FFFF */
-				WRITE_INTERFACE(AI, access_size, addr, data); break;
+				WRITE_INTERFACE(ai_io.write_reg, access_size, addr, data); break;
 
 			case 7: /* $0460'0000 - $046F'FFFF */
-				WRITE_INTERFACE(PI, access_size, addr, data); break;
+				WRITE_INTERFACE(pi_io.write_reg, access_size, addr, data); break;
 
 			case 8: /* $0470'0000 - $047F'FFFF */
-				WRITE_INTERFACE(RI, access_size, addr, data); break;
+				WRITE_INTERFACE(RI::WriteReg, access_size, addr, data); break;
 
 			case 9: /* $0480'0000 - $048F'FFFF */
-				WRITE_INTERFACE(SI, access_size, addr, data); break;
+				WRITE_INTERFACE(si_io.write_reg, access_size, addr, data); break;
 
 			default:
 				std::unreachable();
@@ -6,11 +6,24 @@ import <bit>;
 import <concepts>;
 import <format>;
 
-export namespace Memory
+namespace Memory
 {
-	template<std::signed_integral Int>
-	Int Read(u32 addr);
+	export
+	{
+		template<std::signed_integral Int>
+		Int Read(u32 addr);
 
-	template<size_t access_size, typename... MaskT>
-	void Write(u32 addr, s64 data, MaskT... mask);
+		void SetActiveIoFunctions(); /* call when a log category has been switched */
+
+		template<size_t access_size, typename... MaskT>
+		void Write(u32 addr, s64 data, MaskT... mask);
+	}
+
+	struct IoFunctions {
+		s32(*read_reg)(u32);
+		void(*write_reg)(u32, s32);
+	};
+
+	/* The register functions with or without logging, depending on the interface's log category */
+	thread_local IoFunctions ai_io, mi_io, pi_io, rdp_io, si_io, vi_io;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 module PIF;
 
+import Log;
 import UserMessage;
 
 namespace PIF
@@ -56,6 +57,9 @@ namespace PIF
 	template<bool press>
 	void OnButtonAction(N64::Control control)
 	{
+		if (input_movie_mode == InputMovieMode::Replay) {
+			return;
+		}
 		auto OnShoulderOrStartChanged = [] {
 			if constexpr (press) {
 				if (joypad_status.l && joypad_status.r && joypad_status.s) {
@@ -87,8 +91,41 @@ namespace PIF
 	}
 
 
+	void OnControllerStatePoll()
+	{
+		/* Frames that will be rewound must leave the movie alone: the file cannot be un-written, and neither
+		   joypad_status nor the movie mode is part of a snapshot. They are run with the current input. */
+		if (speculative) {
+			++joybus_poll_index;
+			return;
+		}
+		if (input_movie_mode == InputMovieMode::Record) {
+			InputMovieRecord record = {
+				.poll_index = joybus_poll_index,
+				.joypad_status = std::bit_cast<u32>(joypad_status)
+			};
+			input_movie_out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+		}
+		else {
+			/* Records may be sparse; the most recent state at or before this poll applies */
+			while (input_movie_record_index < input_movie_records.size()
+				&& input_movie_records[input_movie_record_index].poll_index <= joybus_poll_index) {
+				joypad_status = std::bit_cast<JoypadStatus>(input_movie_records[input_movie_record_index++].joypad_status);
+			}
+			if (input_movie_record_index == input_movie_records.size()) {
+				Log::Info(std::format("Input movie replay finished at poll {}", joybus_poll_index));
+				input_movie_mode = InputMovieMode::None;
+			}
+		}
+		++joybus_poll_index;
+	}
+
+
 	void OnJoystickMovement(N64::Control control, s16 value)
 	{
+		if (input_movie_mode == InputMovieMode::Replay) {
+			return;
+		}
 		u8 adjusted_value = u8(value >> 8);
 		if (control == N64::Control::JX) {
 			joypad_status.x_axis = adjusted_value;
@@ -111,6 +148,48 @@ namespace PIF
 	}
 
 
+	bool RecordInputMovie(const std::filesystem::path& path)
+	{
+		StopInputMovie();
+		input_movie_out.open(path, std::ios::binary | std::ios::trunc);
+		if (!input_movie_out) {
+			UserMessage::Error(std::format("Failed to open input movie file {} for writing.", path.string()));
+			return false;
+		}
+		input_movie_out.write(input_movie_magic.data(), input_movie_magic.size());
+		input_movie_out.write(reinterpret_cast<const char*>(&input_movie_version), sizeof(input_movie_version));
+		input_movie_mode = InputMovieMode::Record;
+		joybus_poll_index = 0;
+		return true;
+	}
+
+
+	bool ReplayInputMovie(const std::filesystem::path& path)
+	{
+		StopInputMovie();
+		std::ifstream ifs{ path, std::ios::binary };
+		std::array<char, 4> magic;
+		u32 version;
+		ifs.read(magic.data(), magic.size());
+		ifs.read(reinterpret_cast<char*>(&version), sizeof(version));
+		if (!ifs || magic != input_movie_magic || version != input_movie_version) {
+			UserMessage::Error(std::format("{} is not a valid input movie file.", path.string()));
+			return false;
+		}
+		for (InputMovieRecord record; ifs.read(reinterpret_cast<char*>(&record), sizeof(record)); ) {
+			input_movie_records.push_back(record);
+		}
+		if (input_movie_records.empty()) {
+			return true; /* nothing to replay */
+		}
+		input_movie_mode = InputMovieMode::Replay;
+		input_movie_record_index = 0;
+		joybus_poll_index = 0;
+		joypad_status = {};
+		return true;
+	}
+
+
 	void RomLockout()
 	{
 
@@ -130,6 +209,12 @@ namespace PIF
 			break;
 
 		case 0x01: /* Controller State */
+			if (input_latch_callback && input_movie_mode != InputMovieMode::Replay) {
+				input_latch_callback();
+			}
+			if (input_movie_mode != InputMovieMode::None) {
+				OnControllerStatePoll();
+			}
 			std::memcpy(&memory[ram_start], &joypad_status, sizeof(joypad_status));
 			break;
 
@@ -152,6 +237,35 @@ namespace PIF
 	}
 
 
+	void SetInputLatchCallback(N64::InputLatchCallback callback)
+	{
+		input_latch_callback = callback;
+	}
+
+
+	void SetSpeculative(bool speculative)
+	{
+		PIF::speculative = speculative;
+	}
+
+
+	void StopInputMovie()
+	{
+		if (input_movie_mode == InputMovieMode::Record) {
+			input_movie_out.close();
+		}
+		input_movie_mode = InputMovieMode::None;
+		input_movie_records.clear();
+	}
+
+
+	void StreamState(Serializer& serializer)
+	{
+		/* joypad_status is left out; it mirrors the host controller, not console state */
+		serializer.Stream(memory, joybus_poll_index, input_movie_record_index);
+	}
+
+
 	void TerminateBootProcess()
 	{
 
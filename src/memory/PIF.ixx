@@ -1,6 +1,7 @@
 export module PIF;
 
 import N64;
+import Serializer;
 import Util;
 
 import <algorithm>;
@@ -9,9 +10,12 @@ import <bit>;
 import <concepts>;
 import <cstring>;
 import <filesystem>;
+import <format>;
+import <fstream>;
 import <optional>;
 import <string>;
 import <utility>;
+import <vector>;
 
 namespace PIF
 {
@@ -24,13 +28,33 @@ namespace PIF
 		bool LoadIPL12(const std::filesystem::path& path);
 		void OnJoystickMovement(N64::Control control, s16 value);
 		template<std::signed_integral Int> Int ReadMemory(u32 addr);
+		bool RecordInputMovie(const std::filesystem::path& path);
+		bool ReplayInputMovie(const std::filesystem::path& path);
+		void SetInputLatchCallback(N64::InputLatchCallback callback);
+		void SetSpeculative(bool speculative); /* see OnControllerStatePoll */
+		void StopInputMovie();
+		void StreamState(Serializer& serializer);
 		template<size_t access_size> void WriteMemory(u32 addr, s64 data);
 	}
 
+	/* Input movies log the controller state returned by each joybus controller state command (0x01), keyed by
+	   the index of the poll since the movie was started. A movie started before the game boots replays
+	   deterministically, independent of when the host delivered the input. While replaying, live input is ignored.
+	   File layout: the magic "N6MV", a u32 version, then one record per poll. All values are little-endian. */
+	enum class InputMovieMode {
+		None, Record, Replay
+	};
+
+	struct InputMovieRecord {
+		u32 poll_index;
+		u32 joypad_status;
+	};
+
 	void ChallengeProtection();
 	void ChecksumVerification();
 	void ClearRam();
 	template<bool press> void OnButtonAction(N64::Control control);
+	void OnControllerStatePoll();
 	void RomLockout();
 	void RunJoybusProtocol();
 	void TerminateBootProcess();
@@ -41,7 +65,10 @@ namespace PIF
 	constexpr size_t ram_start = rom_size;
 	constexpr size_t memory_size = ram_size + rom_size;
 
-	struct JoypadStatus {
+	constexpr std::array<char, 4> input_movie_magic = { 'N', '6', 'M', 'V' };
+	constexpr u32 input_movie_version = 1;
+
+	thread_local struct JoypadStatus {
 		u32 a : 1;
 		u32 b : 1;
 		u32 z : 1;
@@ -62,5 +89,16 @@ namespace PIF
 		u32 y_axis : 8;
 	} joypad_status;
 
-	std::array<u8, memory_size> memory; /* $0-$7BF: rom; $7C0-$7FF: ram */
+	static_assert(sizeof(JoypadStatus) == sizeof(u32));
+
+	thread_local N64::InputLatchCallback input_latch_callback; /* lets the frontend update joypad_status right before a poll */
+
+	thread_local InputMovieMode input_movie_mode;
+	thread_local std::ofstream input_movie_out;
+	thread_local std::vector<InputMovieRecord> input_movie_records; /* when replaying */
+	thread_local size_t input_movie_record_index;
+	thread_local u32 joybus_poll_index; /* controller state polls since the movie was started */
+	thread_local bool speculative; /* emulating frames that will be rewound, e.g. for run-ahead */
+
+	thread_local std::array<u8, memory_size> memory; /* $0-$7BF: rom; $7C0-$7FF: ram */
 }
\ No newline at end of file
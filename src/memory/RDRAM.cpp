@@ -5,25 +5,29 @@ namespace RDRAM
 	size_t GetNumberOfBytesUntilMemoryEnd(u32 addr)
 	{
 		/* TODO handle mirroring (for DMA) */
-		return sizeof(rdram) - (addr & (sizeof(rdram) - 1));
+		return rdram_expanded_size - (addr & (rdram_expanded_size - 1));
 	}
 
 
 	u8* GetPointerToMemory(u32 addr)
 	{
-		return rdram + (addr & (sizeof(rdram) - 1));
+		return rdram + (addr & (rdram_expanded_size - 1));
 	}
 
 
 	size_t GetSize()
 	{
-		return sizeof(rdram);
+		return rdram_expanded_size;
 	}
 
 
 	void Initialize()
 	{
-		std::memset(rdram, 0, sizeof(rdram));
+		if (!rdram_allocation) {
+			rdram_allocation = std::make_unique<RdramAllocation>();
+			rdram = rdram_allocation->bytes;
+		}
+		std::memset(rdram, 0, rdram_expanded_size);
 		std::memset(&reg, 0, sizeof(reg));
 		/* values taken from Peter Lemon RDRAMTest */
 		reg.device_type = 0xB419'0010;
@@ -37,7 +41,7 @@ namespace RDRAM
 	Int Read(u32 addr)
 	{ /* CPU precondition: addr is always aligned */
 		Int ret;
-		std::memcpy(&ret, rdram + (addr & (sizeof(rdram) - 1)), sizeof(Int));
+		std::memcpy(&ret, rdram + (addr & (rdram_expanded_size - 1)), sizeof(Int));
 		return std::byteswap(ret);
 	}
 
@@ -58,7 +62,7 @@ namespace RDRAM
 		/* addr may be misaligned */
 		u64 command;
 		for (int i = 0; i < 8; ++i) {
-			*((u8*)(&command) + i) = rdram[(addr + 7 - i) & (sizeof(rdram) - 1)];
+			*((u8*)(&command) + i) = rdram[(addr + 7 - i) & (rdram_expanded_size - 1)];
 		}
 		return command;
 	}
@@ -69,12 +73,19 @@ namespace RDRAM
 		/* addr may be misaligned */
 		u64 command;
 		for (int i = 0; i < 8; ++i) {
-			*((u8*)(&command) + i) = rdram[(addr + i) & (sizeof(rdram) - 1)];
+			*((u8*)(&command) + i) = rdram[(addr + i) & (rdram_expanded_size - 1)];
 		}
 		return command;
 	}
 
 
+	void StreamState(Serializer& serializer)
+	{
+		serializer.Stream(reg);
+		serializer.StreamBytes(rdram, rdram_expanded_size);
+	}
+
+
 	/* 0 - $7F'FFFF */
 	template<size_t access_size, typename... MaskT>
 	void Write(u32 addr, s64 data, MaskT... mask)
@@ -91,7 +102,7 @@ namespace RDRAM
 		if constexpr (apply_mask) {
 			addr &= ~(access_size - 1);
 		}
-		u8* ram = rdram + (addr & (sizeof(rdram) - 1));
+		u8* ram = rdram + (addr & (rdram_expanded_size - 1));
 		if constexpr (apply_mask) {
 			u64 existing;
 			std::memcpy(&existing, ram, access_size);
@@ -1,10 +1,12 @@
 export module RDRAM;
 
+import Serializer;
 import Util;
 
 import <bit>;
 import <concepts>;
 import <cstring>;
+import <memory>;
 
 namespace RDRAM
 {
@@ -18,11 +20,12 @@ namespace RDRAM
 		s32 ReadReg(u32 addr);
 		u64 RdpReadCommandByteswapped(u32 addr);
 		u32 RdpReadCommand(u32 addr);
+		void StreamState(Serializer& serializer);
 		template<size_t access_size, typename... MaskT> void Write(u32 addr, s64 data, MaskT... mask);
 		void WriteReg(u32 addr, s32 data);
 	}
 
-	struct Reg {
+	thread_local struct Reg {
 		u32 device_type, device_id, delay, mode, ref_interval, ref_row,
 			ras_interval, min_interval, addr_select, device_manuf,
 			dummy0, dummy1, dummy2, dummy3, dummy4, dummy5;
@@ -33,5 +36,11 @@ namespace RDRAM
 
 	/* Note: could not use std::array here as .data() does not become properly aligned */
 	/* TODO: parallel-rdp required 4096 on my system. Investigate further. */
-	alignas(4096) u8 rdram[rdram_expanded_size]; /* TODO: make it dynamic? */
+	struct alignas(4096) RdramAllocation {
+		u8 bytes[rdram_expanded_size];
+	};
+
+	/* Allocated on the heap rather than being thread_local itself, so that threads without a machine do not get 8 MiB of TLS */
+	thread_local std::unique_ptr<RdramAllocation> rdram_allocation;
+	thread_local u8* rdram;
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 module RDP;
 
 import BuildOptions;
+import FrameTiming;
 import Log;
 import MI;
 import ParallelRDPWrapper;
+import RDPCapture;
 import RDPImplementation;
 import RDRAM;
 import RSP;
@@ -15,6 +17,8 @@ namespace RDP
 	{
 		std::memset(&dp, 0, sizeof(dp));
 		dp.status.ready = 1;
+		cmd_buffer.resize(cmd_buffer_word_capacity);
+		queue_word_offset = num_queued_words = 0;
 	}
 
 
@@ -33,6 +37,7 @@ namespace RDP
 	template<CommandLocation cmd_loc>
 	void LoadExecuteCommands()
 	{
+		FrameTiming::Scope timing_scope{ FrameTiming::Unit::Rdp };
 		if (dp.status.freeze) {
 			return;
 		}
@@ -69,10 +74,20 @@ namespace RDP
 				return;
 			}
 			if (opcode >= 8) {
-				implementation->EnqueueCommand(cmd_word_len, &cmd_buffer[queue_word_offset]);
+				if constexpr (capture_rdp_commands) {
+					RDPCapture::RecordCommand(&cmd_buffer[queue_word_offset], cmd_word_len);
+				}
+				if (implementation) {
+					implementation->EnqueueCommand(cmd_word_len, &cmd_buffer[queue_word_offset]);
+				}
 			}
 			if (opcode == 0x29) { /* full sync command */
-				implementation->OnFullSync();
+				if constexpr (capture_rdp_commands) {
+					RDPCapture::RecordFullSync();
+				}
+				if (implementation) {
+					implementation->OnFullSync();
+				}
 				dp.status.pipe_busy = dp.status.start_gclk = false;
 				MI::SetInterruptFlag(MI::InterruptType::DP);
 
@@ -95,6 +110,7 @@ namespace RDP
 	}
 
 
+	template<bool log>
 	s32 ReadReg(u32 addr)
 	{
 		/* TODO: RCP will ignore the requested access size and will just put the requested 32-bit word on the bus.
@@ -105,7 +121,7 @@ namespace RDP
 		u32 offset = addr >> 2 & 7;
 		s32 ret;
 		std::memcpy(&ret, (s32*)(&dp) + offset, 4);
-		if constexpr (log_io_rdp) {
+		if constexpr (log) {
 			Log::IoRead("RDP", RegOffsetToStr(offset), ret);
 		}
 		return ret;
@@ -128,6 +144,15 @@ namespace RDP
 	}
 
 
+	void StreamState(Serializer& serializer)
+	{
+		/* Only the queued words; the rest of the 4 MiB buffer is not read before it has been written again */
+		serializer.Stream(dp, queue_word_offset, num_queued_words);
+		serializer.StreamBytes(cmd_buffer.data(), num_queued_words * sizeof(u32));
+	}
+
+
+	template<bool log>
 	void WriteReg(u32 addr, s32 data)
 	{
 		auto ProcessCommands = [&] {
@@ -138,7 +163,7 @@ namespace RDP
 
 		static_assert(sizeof(dp) >> 2 == 8);
 		u32 offset = addr >> 2 & 7;
-		if constexpr (log_io_rdp) {
+		if constexpr (log) {
 			Log::IoWrite("RDP", RegOffsetToStr(offset), data);
 		}
 
@@ -200,4 +225,10 @@ namespace RDP
 		} break;
 		}
 	}
+
+
+	template s32 ReadReg<false>(u32);
+	template s32 ReadReg<true>(u32);
+	template void WriteReg<false>(u32, s32);
+	template void WriteReg<true>(u32, s32);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 export module RDP;
 
 import RDPImplementation;
+import Serializer;
 import Util;
 
 import <array>;
@@ -8,6 +9,7 @@ import <cassert>;
 import <cstring>;
 import <memory>;
 import <string_view>;
+import <vector>;
 
 namespace RDP
 {
@@ -15,10 +17,11 @@ namespace RDP
 	{
 		void Initialize();
 		bool MakeParallelRdp();
-		s32 ReadReg(u32 addr);
-		void WriteReg(u32 addr, s32 data);
+		template<bool log> s32 ReadReg(u32 addr);
+		void StreamState(Serializer& serializer);
+		template<bool log> void WriteReg(u32 addr, s32 data);
 
-		std::unique_ptr<RDPImplementation> implementation;
+		thread_local std::unique_ptr<RDPImplementation> implementation;
 	}
 
 	enum class CommandLocation {
@@ -29,7 +32,7 @@ namespace RDP
 		StartReg, EndReg, CurrentReg, StatusReg, ClockReg, BufBusyReg, PipeBusyReg, TmemReg
 	};
 
-	struct Dp {
+	thread_local struct Dp {
 		u32 start, end, current;
 		struct {
 			u32 cmd_source : 1;
@@ -52,8 +55,8 @@ namespace RDP
 	template<CommandLocation> void LoadExecuteCommands();
 	constexpr std::string_view RegOffsetToStr(u32 reg_offset);
 
-	u32 queue_word_offset;
-	u32 num_queued_words;
-	std::array<u32, 0x100000> cmd_buffer;
-	constexpr u32 cmd_buffer_word_capacity = cmd_buffer.size();
+	thread_local u32 queue_word_offset;
+	thread_local u32 num_queued_words;
+	thread_local std::vector<u32> cmd_buffer; /* allocated in Initialize, so that threads without a machine do not get it as TLS */
+	constexpr u32 cmd_buffer_word_capacity = 0x100000;
 }
\ No newline at end of file
@@ -0,0 +1,299 @@
+module RDPCapture;
+
+import RDP;
+import RDRAM;
+
+namespace RDPCapture
+{
+	template<typename T>
+	void Append(T value)
+	{
+		u8 bytes[sizeof(T)];
+		std::memcpy(bytes, &value, sizeof(T));
+		pending_records.insert(pending_records.end(), std::begin(bytes), std::end(bytes));
+	}
+
+
+	u64 CommandDword(u32 const* words)
+	{
+		/* The first dword of a command as it was in RDRAM. Each dword is loaded into the command buffer as a
+		   host-order u64 (see LoadExecuteCommands in RDP), so the high word comes second. */
+		return u64(words[1]) << 32 | words[0];
+	}
+
+
+	bool IsCapturing()
+	{
+		return capturing;
+	}
+
+
+	std::optional<ReplayOptions> ParseReplayArgs(std::span<char* const> args)
+	{
+		if (args.empty()) {
+			return {};
+		}
+		ReplayOptions options = {
+			.path = args[0],
+			.backend = "null",
+			.num_loops = default_num_replay_loops
+		};
+		for (size_t i = 1; i < args.size(); ++i) {
+			std::string_view arg = args[i];
+			bool has_value = i + 1 < args.size();
+			try {
+				if (arg == "--backend" && has_value) {
+					options.backend = args[++i];
+				}
+				else if (arg == "--loops" && has_value) {
+					options.num_loops = std::max(1, std::stoi(args[++i]));
+				}
+				else {
+					return {};
+				}
+			}
+			catch (...) {
+				return {};
+			}
+		}
+		if (options.backend != "null" && options.backend != "parallel-rdp") {
+			return {};
+		}
+		return options;
+	}
+
+
+	void PrintReplayUsage()
+	{
+		std::cerr << "Usage: --replay-rdp <file> [--backend null|parallel-rdp] [--loops N]\n"
+			"  --backend B  the RDP implementation to replay through (default: null, which drops the commands)\n"
+			"  --loops N    number of times to replay the capture (default: " << default_num_replay_loops << ")\n";
+	}
+
+
+	void RecordCommand(u32 const* words, u32 num_words)
+	{
+		if (!capturing) {
+			return;
+		}
+		u64 dword = CommandDword(words);
+		u32 opcode = dword >> 56 & 0x3F;
+		if (opcode == 0x3D) { /* Set Texture Image */
+			/* Tracked also before the first full sync, since the loads after it refer to the image it set */
+			texture_image.addr = dword & 0xFF'FFFF;
+			texture_image.size = dword >> 51 & 3;
+			texture_image.width = (dword >> 32 & 0x3FF) + 1;
+		}
+		if (waiting_for_full_sync) {
+			return;
+		}
+		switch (opcode) {
+		case 0x30: /* Load TLUT */
+		case 0x33: /* Load Block */
+		case 0x34: { /* Load Tile */
+			/* s and t are in 10.2 fixed point, except for Load Block, where they are texel indices */
+			u32 shift = opcode == 0x33 ? 0 : 2;
+			u32 sl = (dword >> 44 & 0xFFF) >> shift, tl = (dword >> 32 & 0xFFF) >> shift;
+			u32 sh = (dword >> 12 & 0xFFF) >> shift, th = opcode == 0x33 ? tl : (dword & 0xFFF) >> shift;
+			u32 first_texel = tl * texture_image.width + sl;
+			u32 last_texel = th * texture_image.width + sh;
+			if (last_texel >= first_texel) {
+				u32 begin = texture_image.addr + (first_texel << texture_image.size >> 1);
+				u32 end = texture_image.addr + (((last_texel + 1) << texture_image.size) + 1 >> 1);
+				SnapshotRdram(begin, end - begin);
+			}
+			break;
+		}
+		}
+		Append(RecordType::Command);
+		Append(u8(num_words));
+		for (u32 i = 0; i < num_words; ++i) {
+			Append(words[i]);
+		}
+	}
+
+
+	void RecordFullSync()
+	{
+		if (!capturing) {
+			return;
+		}
+		if (waiting_for_full_sync) {
+			waiting_for_full_sync = false;
+			return;
+		}
+		Append(RecordType::FullSync);
+		file.write(reinterpret_cast<char const*>(pending_records.data()), pending_records.size());
+		pending_records.clear();
+	}
+
+
+	int Replay(std::span<char* const> args)
+	{
+		std::optional<ReplayOptions> options = ParseReplayArgs(args);
+		if (!options.has_value()) {
+			PrintReplayUsage();
+			return 2;
+		}
+
+		std::ifstream ifs{ options->path, std::ios::binary };
+		std::vector<u8> contents{ std::istreambuf_iterator<char>(ifs), {} };
+		Header file_header{};
+		if (contents.size() >= sizeof(file_header)) {
+			std::memcpy(&file_header, contents.data(), sizeof(file_header));
+		}
+		if (file_header.magic != magic || file_header.version != version) {
+			std::cerr << std::format("[error] {} is not an RDP capture\n", options->path.string());
+			return 2;
+		}
+
+		/* Parse everything up front, so that only the implementation's work is timed */
+		std::vector<ReplayOp> ops;
+		std::vector<u32> cmd_words; /* copied out of the file, since implementations take mutable, aligned words */
+		size_t num_commands = 0, num_full_syncs = 0, num_snapshot_bytes = 0;
+		size_t pos = sizeof(file_header);
+		auto Read = [&]<typename T>(T& value) {
+			if (pos + sizeof(T) > contents.size()) {
+				return false;
+			}
+			std::memcpy(&value, contents.data() + pos, sizeof(T));
+			pos += sizeof(T);
+			return true;
+		};
+		while (pos < contents.size()) {
+			ReplayOp op{};
+			bool ok = Read(op.type);
+			switch (op.type) {
+			case RecordType::Command: {
+				u8 num_words;
+				ok = ok && Read(num_words) && pos + 4 * num_words <= contents.size();
+				if (ok) {
+					op.num_words = num_words;
+					op.offset = cmd_words.size();
+					cmd_words.resize(cmd_words.size() + num_words);
+					std::memcpy(cmd_words.data() + op.offset, contents.data() + pos, 4 * num_words);
+					pos += 4 * num_words;
+					num_commands++;
+				}
+				break;
+			}
+			case RecordType::FullSync:
+				num_full_syncs++;
+				break;
+
+			case RecordType::RdramSnapshot:
+				ok = ok && Read(op.addr) && Read(op.size) && pos + op.size <= contents.size()
+					&& op.addr < RDRAM::GetSize() && op.size <= RDRAM::GetNumberOfBytesUntilMemoryEnd(op.addr);
+				if (ok) {
+					op.offset = pos;
+					pos += op.size;
+					num_snapshot_bytes += op.size;
+				}
+				break;
+
+			default:
+				ok = false;
+			}
+			if (!ok) {
+				std::cerr << std::format("[error] {} is truncated or corrupt at offset {}\n", options->path.string(), pos);
+				return 2;
+			}
+			ops.push_back(op);
+		}
+
+		RDRAM::Initialize();
+		RDPImplementation* implementation;
+		std::unique_ptr<RDPImplementation> null_implementation;
+		if (options->backend == "parallel-rdp") {
+			if (!RDP::MakeParallelRdp()) {
+				std::cerr << "[error] Failed to initialize parallel-rdp\n";
+				return 1;
+			}
+			implementation = RDP::implementation.get();
+		}
+		else {
+			null_implementation = std::make_unique<NullRDPImplementation>();
+			implementation = null_implementation.get();
+		}
+
+		std::cout << std::format("{} commands, {} full syncs, {} KiB of RDRAM snapshots\n",
+			num_commands, num_full_syncs, num_snapshot_bytes / 1024);
+		f64 best_ms = std::numeric_limits<f64>::max();
+		for (uint loop = 0; loop < options->num_loops; ++loop) {
+			auto start_time = std::chrono::steady_clock::now();
+			for (ReplayOp const& op : ops) {
+				switch (op.type) {
+				case RecordType::Command:
+					implementation->EnqueueCommand(int(op.num_words), cmd_words.data() + op.offset);
+					break;
+
+				case RecordType::FullSync:
+					implementation->OnFullSync();
+					break;
+
+				case RecordType::RdramSnapshot:
+					std::memcpy(RDRAM::GetPointerToMemory(op.addr), contents.data() + op.offset, op.size);
+					break;
+				}
+			}
+			f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+			best_ms = std::min(best_ms, ms);
+			std::cout << std::format("loop {}: {:.3f} ms\n", loop + 1, ms);
+		}
+		std::cout << std::format("best: {:.3f} ms ({:.3f} ms per full sync, {:.1f} M commands/s)\n", best_ms,
+			best_ms / f64(std::max<size_t>(1, num_full_syncs)), f64(num_commands) / best_ms / 1000.0);
+		implementation->TearDown();
+		return 0;
+	}
+
+
+	void SnapshotRdram(u32 addr, u32 size)
+	{
+		addr &= RDRAM::GetSize() - 1;
+		size = u32(std::min<size_t>({ size, max_snapshot_size, RDRAM::GetNumberOfBytesUntilMemoryEnd(addr) }));
+		u8 const* bytes = RDRAM::GetPointerToMemory(addr);
+		u64 hash = fnv_offset_basis;
+		for (u32 i = 0; i < size; ++i) {
+			hash = (hash ^ bytes[i]) * fnv_prime;
+		}
+		auto [it, inserted] = snapshot_hashes.try_emplace(u64(addr) << 32 | size, hash);
+		if (!inserted) {
+			if (it->second == hash) {
+				return;
+			}
+			it->second = hash;
+		}
+		Append(RecordType::RdramSnapshot);
+		Append(addr);
+		Append(size);
+		pending_records.insert(pending_records.end(), bytes, bytes + size);
+	}
+
+
+	bool Start(std::filesystem::path const& path)
+	{
+		Stop();
+		file.open(path, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			return false;
+		}
+		Header file_header = { .magic = magic, .version = version };
+		file.write(reinterpret_cast<char const*>(&file_header), sizeof(file_header));
+		pending_records.clear();
+		snapshot_hashes.clear();
+		texture_image = {};
+		capturing = waiting_for_full_sync = true;
+		return true;
+	}
+
+
+	void Stop()
+	{
+		/* Records since the last full sync are dropped, so that the capture ends on a frame boundary */
+		if (capturing) {
+			file.close();
+			pending_records.clear();
+			capturing = false;
+		}
+	}
+}
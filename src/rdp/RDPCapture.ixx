@@ -0,0 +1,93 @@
+export module RDPCapture;
+
+import RDPImplementation;
+import Util;
+
+import <algorithm>;
+import <array>;
+import <chrono>;
+import <cstring>;
+import <filesystem>;
+import <format>;
+import <fstream>;
+import <iostream>;
+import <iterator>;
+import <limits>;
+import <memory>;
+import <optional>;
+import <span>;
+import <string>;
+import <string_view>;
+import <unordered_map>;
+import <vector>;
+
+/* Capture of the RDP command stream, compiled in with 'capture_rdp_commands' in BuildOptions and switched on and
+   off under Debug > Capture RDP commands. Every command passed to the RDP implementation is recorded, along with
+   the full syncs and the RDRAM ranges that texture and TLUT loads read from, so that the stream can be replayed
+   without the CPU or RSP. A capture starts at the next full sync, so that it never begins mid-frame. Snapshots of
+   a range are skipped if its contents are unchanged since it was last recorded. Records are buffered in memory
+   and written to the file at each full sync.
+   '--replay-rdp <file>' pushes a capture through an RDP implementation as fast as it accepts it, to benchmark
+   and profile RDP backends on identical workloads. */
+namespace RDPCapture
+{
+	export
+	{
+		bool IsCapturing();
+		void RecordCommand(u32 const* words, u32 num_words);
+		void RecordFullSync();
+		int Replay(std::span<char* const> args); /* returns the process exit code */
+		bool Start(std::filesystem::path const& path);
+		void Stop();
+	}
+
+	enum class RecordType : u8 {
+		Command, /* u8 number of words, followed by the words */
+		FullSync,
+		RdramSnapshot /* u32 RDRAM address, u32 size in bytes, followed by the bytes */
+	};
+
+	struct Header {
+		std::array<char, 4> magic;
+		u32 version;
+	};
+
+	struct ReplayOp {
+		RecordType type;
+		u32 num_words; /* Command */
+		u32 addr, size; /* RdramSnapshot */
+		size_t offset; /* into the replay's command words (Command) or file contents (RdramSnapshot) */
+	};
+
+	struct ReplayOptions {
+		std::filesystem::path path;
+		std::string backend;
+		uint num_loops;
+	};
+
+	template<typename T> void Append(T value);
+	u64 CommandDword(u32 const* words);
+	std::optional<ReplayOptions> ParseReplayArgs(std::span<char* const> args);
+	void PrintReplayUsage();
+	void SnapshotRdram(u32 addr, u32 size);
+
+	constexpr std::array<char, 4> magic = { 'N', '6', 'R', 'C' };
+	constexpr u32 version = 1;
+	constexpr u32 max_snapshot_size = 0x10'0000;
+	constexpr uint default_num_replay_loops = 10;
+	constexpr u64 fnv_offset_basis = 0xCBF2'9CE4'8422'2325;
+	constexpr u64 fnv_prime = 0x100'0000'01B3;
+
+	thread_local bool capturing;
+	thread_local bool waiting_for_full_sync;
+	thread_local std::ofstream file;
+	thread_local std::vector<u8> pending_records; /* since the last full sync */
+	thread_local std::unordered_map<u64, u64> snapshot_hashes; /* key: addr << 32 | size */
+
+	/* The last Set Texture Image command, which the load commands read from */
+	thread_local struct {
+		u32 addr;
+		u32 size; /* texel size; 0 => 4 bits, 1 => 8 bits, 2 => 16 bits, 3 => 32 bits */
+		u32 width; /* in texels */
+	} texture_image;
+}
@@ -11,4 +11,14 @@ public:
 	virtual void OnFullSync() = 0;
 	virtual void TearDown() = 0;
 	virtual void UpdateScreen() = 0;
+};
+
+/* Accepts commands and drops them, to measure the emulator's side of command submission on its own */
+export class NullRDPImplementation final : public RDPImplementation {
+public:
+	void EnqueueCommand(int cmd_len, u32* cmd_ptr) override {}
+	bool Initialize() override { return true; }
+	void OnFullSync() override {}
+	void TearDown() override {}
+	void UpdateScreen() override {}
 };
\ No newline at end of file
@@ -0,0 +1,49 @@
+module RSP:Benchmarks;
+
+import :VectorUnit;
+
+import Bench;
+
+namespace RSP
+{
+	template<auto instr_fun>
+	void MeasureInstr(std::string_view name)
+	{
+		Bench::Measure(std::format("RSP {}", name), [](u64 i) {
+			instr_fun(bench_instr_codes[i % bench_instr_codes.size()]);
+		});
+		Bench::Consume(_mm_extract_epi16(vpr[0], 0));
+	}
+
+
+	void RunBenchmarks()
+	{
+		using enum VectorInstruction;
+
+		std::mt19937 rng{ 0x5EED };
+		for (__m128i& reg : vpr) {
+			reg = _mm_set_epi32(rng(), rng(), rng(), rng());
+		}
+		for (u32& instr_code : bench_instr_codes) {
+			u32 element = rng() & 0xF, vt = rng() & 0x1F, vs = rng() & 0x1F, vd = rng() & 0x1F;
+			instr_code = element << 21 | vt << 16 | vs << 11 | vd << 6;
+		}
+
+		MeasureInstr<ComputeInstr<VMULF>>("VMULF");
+		MeasureInstr<ComputeInstr<VMUDH>>("VMUDH");
+		MeasureInstr<ComputeInstr<VMUDN>>("VMUDN");
+		MeasureInstr<ComputeInstr<VMACF>>("VMACF");
+		MeasureInstr<ComputeInstr<VMADH>>("VMADH");
+		MeasureInstr<ComputeInstr<VMADN>>("VMADN");
+		MeasureInstr<ComputeInstr<VADD>>("VADD");
+		MeasureInstr<ComputeInstr<VADDC>>("VADDC");
+		MeasureInstr<ComputeInstr<VSUB>>("VSUB");
+		MeasureInstr<ComputeInstr<VAND>>("VAND");
+		MeasureInstr<SelectInstr<VLT>>("VLT");
+		MeasureInstr<SelectInstr<VEQ>>("VEQ");
+		MeasureInstr<SelectInstr<VGE>>("VGE");
+		MeasureInstr<SelectInstr<VCH>>("VCH");
+		MeasureInstr<SelectInstr<VCL>>("VCL");
+		MeasureInstr<SelectInstr<VMRG>>("VMRG");
+	}
+}
@@ -0,0 +1,23 @@
+export module RSP:Benchmarks;
+
+import Util;
+
+import <array>;
+import <format>;
+import <random>;
+import <string_view>;
+
+import <immintrin.h>;
+
+namespace RSP
+{
+	export
+	{
+		void RunBenchmarks(); /* see Bench; clobbers the vector unit state */
+	}
+
+	template<auto instr_fun> void MeasureInstr(std::string_view name);
+
+	/* Random vd/vs/vt/element combinations, cycled through by the benchmarked instructions */
+	thread_local std::array<u32, 256> bench_instr_codes;
+}
@@ -4,24 +4,32 @@ import :ScalarUnit;
 import :VectorUnit;
 
 import BuildOptions;
+import InstructionHistogram;
 import Log;
 import Util;
 
 
+#define COUNT_INSTR(HISTOGRAM, INSTR_CLASS, INSTR) { \
+	if constexpr (instruction_histograms) { \
+		static_assert(std::to_underlying(INSTR_CLASS::INSTR) < InstructionHistogram::max_instructions); \
+		HISTOGRAM.Increment(std::to_underlying(INSTR_CLASS::INSTR), #INSTR); } }
+
 #define EXEC_SCALAR_INSTR(INSTR) { \
 	if constexpr (log_rsp_instructions) \
 		current_instr_name = #INSTR; \
+	COUNT_INSTR(scalar_instr_histogram, ScalarInstruction, INSTR); \
 	ExecuteScalarInstruction<ScalarInstruction::INSTR>(); }
 
 #define EXEC_VECTOR_INSTR(INSTR) { \
 	if constexpr (log_rsp_instructions) \
 		current_instr_name = #INSTR; \
+	COUNT_INSTR(vector_instr_histogram, VectorInstruction, INSTR); \
 	ExecuteVectorInstruction<VectorInstruction::INSTR>(); }
 
 
 namespace RSP
 {
-	u32 instr_code;
+	thread_local u32 instr_code;
 
 
 	void DecodeExecuteCop0Instruction()
@@ -272,9 +280,12 @@ namespace RSP
 		else {
 			static_assert(AlwaysFalse<instr>);
 		}
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			Log::RspInstruction(current_instr_pc, current_instr_log_output);
 		}
+		else if constexpr (log_rsp_instructions) {
+			Log::RspInstruction(current_instr_pc, current_instr_name, instr_code);
+		}
 	}
 
 
@@ -304,8 +315,11 @@ namespace RSP
 		else {
 			static_assert(AlwaysFalse<instr>);
 		}
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			Log::RspInstruction(current_instr_pc, current_instr_log_output);
 		}
+		else if constexpr (log_rsp_instructions) {
+			Log::RspInstruction(current_instr_pc, current_instr_name, instr_code);
+		}
 	}
 }
\ No newline at end of file
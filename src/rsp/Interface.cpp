@@ -5,6 +5,8 @@ import :Operation;
 import BuildOptions;
 import Log;
 import MI;
+import Profiler;
+import RDP;
 import RDRAM;
 import Scheduler;
 
@@ -77,7 +79,7 @@ namespace RSP
 			}
 		}
 
-		if constexpr (log_dma) {
+		if (Log::IsEnabled(Log::Category::Dma)) {
 			std::string_view rsp_mem_bank = sp.dma_spaddr & 0x1000 ? "IMEM" : "DMEM";
 			std::string output = [&] {
 				if constexpr (dma_type == DmaType::RdToSp) {
@@ -89,7 +91,7 @@ namespace RSP
 						rsp_mem_bank, sp.dma_spaddr & 0xFFF, sp.dma_ramaddr & 0xFF'FFFF, requested_total_bytes);
 				}
 			}();
-			//LogDma(output);
+			Log::Dma(output);
 		}
 	}
 
@@ -133,12 +135,13 @@ namespace RSP
 	}
 
 
+	template<bool log>
 	s32 ReadReg(u32 addr)
 	{
 		if (addr == sp_pc_addr) {
 			// TODO: return random number if !halted, else pc
 			//return halted ? pc : Int(Random<s32>(0, 0xFFF));
-			if constexpr (log_io_rsp) {
+			if constexpr (log) {
 				Log::IoRead("RSP", "SP_PC", pc);
 			}
 			return pc;
@@ -197,7 +200,7 @@ namespace RSP
 					std::unreachable();
 				}
 			}();
-			if constexpr (log_io_rsp) {
+			if constexpr (log) {
 				Log::IoRead("RSP", RegOffsetToStr(offset), ret);
 			}
 			return ret;
@@ -221,19 +224,41 @@ namespace RSP
 	}
 
 
+	void SetActiveIoFunctions()
+	{
+		if (Log::IsEnabled(Log::Category::IoRsp)) {
+			active_read_reg = ReadReg<true>;
+			active_write_reg = WriteReg<true>;
+		}
+		else {
+			active_read_reg = ReadReg<false>;
+			active_write_reg = WriteReg<false>;
+		}
+		if (Log::IsEnabled(Log::Category::IoRdp)) {
+			active_rdp_read_reg = RDP::ReadReg<true>;
+			active_rdp_write_reg = RDP::WriteReg<true>;
+		}
+		else {
+			active_rdp_read_reg = RDP::ReadReg<false>;
+			active_rdp_write_reg = RDP::WriteReg<false>;
+		}
+	}
+
+
+	template<bool log>
 	void WriteReg(u32 addr, s32 data)
 	{
 		if (addr == sp_pc_addr) {
 			pc = data & 0xFFC;
 			jump_is_pending = in_branch_delay_slot = false;
-			if constexpr (log_io_rsp) {
+			if constexpr (log) {
 				Log::IoWrite("RSP", "SP_PC", data);
 			}
 		}
 		else {
 			static_assert(sizeof(sp) >> 2 == 8);
 			u32 offset = addr >> 2 & 7;
-			if constexpr (log_io_rsp) {
+			if constexpr (log) {
 				Log::IoWrite("RSP", RegOffsetToStr(offset), data);
 			}
 
@@ -277,6 +302,15 @@ namespace RSP
 			case Status: {
 				if ((data & 1) && !(data & 2)) {
 					/* CLR_HALT: Start running RSP code from the current RSP PC (clear the HALTED flag) */
+					if constexpr (profile_guest) {
+						if (sp.status.halted) {
+							u64 imem_hash = 0xCBF2'9CE4'8422'2325; /* FNV-1a */
+							for (size_t i = 0x1000; i < 0x2000; ++i) {
+								imem_hash = (imem_hash ^ mem[i]) * 0x100'0000'01B3;
+							}
+							Profiler::OnRspStart(imem_hash);
+						}
+					}
 					sp.status.halted = 0;
 				}
 				else if (!(data & 1) && (data & 2)) {
@@ -349,4 +383,10 @@ namespace RSP
 			}
 		}
 	}
+
+
+	template s32 ReadReg<false>(u32);
+	template s32 ReadReg<true>(u32);
+	template void WriteReg<false>(u32, s32);
+	template void WriteReg<true>(u32, s32);
 }
\ No newline at end of file
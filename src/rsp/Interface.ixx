@@ -14,8 +14,9 @@ namespace RSP
 {
 	export
 	{
-		s32 ReadReg(u32 addr);
-		void WriteReg(u32 addr, s32 data);
+		template<bool log> s32 ReadReg(u32 addr);
+		void SetActiveIoFunctions();
+		template<bool log> void WriteReg(u32 addr, s32 data);
 	}
 
 	enum class DmaType {
@@ -31,7 +32,7 @@ namespace RSP
 
 	constexpr std::string_view RegOffsetToStr(u32 reg_offset);
 
-	struct Sp {
+	thread_local struct Sp {
 		u32 dma_spaddr, dma_ramaddr, dma_rdlen, dma_wrlen;
 		struct {
 			u32 halted : 1;
@@ -49,16 +50,23 @@ namespace RSP
 
 	constexpr s32 sp_pc_addr = 0x0408'0000;
 
-	bool dma_in_progress;
-	bool dma_is_pending;
+	thread_local bool dma_in_progress;
+	thread_local bool dma_is_pending;
 
 	/* What was written last to either SP_DMA_RDLEN/ SP_DMA_WRLEN during an ongoing DMA */
-	s32 buffered_dma_rdlen;
-	s32 buffered_dma_wrlen;
-	s32 dma_spaddr_last_addr;
-	s32 dma_ramaddr_last_addr;
+	thread_local s32 buffered_dma_rdlen;
+	thread_local s32 buffered_dma_wrlen;
+	thread_local s32 dma_spaddr_last_addr;
+	thread_local s32 dma_ramaddr_last_addr;
 
-	DmaType in_progress_dma_type;
+	thread_local DmaType in_progress_dma_type;
 
-	void(*init_pending_dma_fun_ptr)();
+	thread_local void(*init_pending_dma_fun_ptr)();
+
+	/* The RSP's and RDP's register functions with or without logging, as called by the RSP through COP0 and by
+	   the CPU through ReadMemoryCpu/WriteMemoryCpu. See SetActiveIoFunctions. */
+	thread_local s32(*active_read_reg)(u32);
+	thread_local void(*active_write_reg)(u32, s32);
+	thread_local s32(*active_rdp_read_reg)(u32);
+	thread_local void(*active_rdp_write_reg)(u32, s32);
 }
\ No newline at end of file
@@ -32,6 +32,12 @@ namespace RSP
 	}
 
 
+	bool IsHalted()
+	{
+		return sp.status.halted;
+	}
+
+
 	void NotifyIllegalInstrCode(u32 instr_code)
 	{
 		std::cout << std::format("Illegal RSP instruction code {:08X} encountered.\n", instr_code);
@@ -45,6 +51,10 @@ namespace RSP
 		mem.fill(0);
 		std::memset(&sp, 0, sizeof(sp));
 		sp.status.halted = true;
+		if constexpr (instruction_histograms) {
+			scalar_instr_histogram.Reset();
+			vector_instr_histogram.Reset();
+		}
 	}
 
 
@@ -77,7 +87,7 @@ namespace RSP
 			return std::byteswap(ret);
 		}
 		else if constexpr (sizeof(Int) == 4) {
-			return ReadReg(addr);
+			return active_read_reg(addr);
 		}
 		else {
 			Log::Warning(std::format(
@@ -139,6 +149,17 @@ namespace RSP
 	}
 
 
+	void StreamState(Serializer& serializer)
+	{
+		/* The state of all partitions */
+		serializer.Stream(sp, dma_in_progress, dma_is_pending, buffered_dma_rdlen, buffered_dma_wrlen,
+			dma_spaddr_last_addr, dma_ramaddr_last_addr, in_progress_dma_type, init_pending_dma_fun_ptr);
+		serializer.Stream(in_branch_delay_slot, jump_is_pending, pc, instructions_until_jump, addr_to_jump_to, mem);
+		serializer.Stream(gpr, ll_bit);
+		serializer.Stream(acc, div_out, div_in, div_dp, vpr, ctrl_reg);
+	}
+
+
 	template<std::signed_integral Int>
 	void WriteDMEM(u32 addr, Int data)
 	{
@@ -149,6 +170,13 @@ namespace RSP
 	}
 
 
+	void WriteInstructionHistograms(std::ostream& os)
+	{
+		scalar_instr_histogram.WriteCsv(os, "rsp", "scalar");
+		vector_instr_histogram.WriteCsv(os, "rsp", "vector");
+	}
+
+
 	template<size_t access_size>
 	void WriteMemoryCpu(u32 addr, s64 data)
 	{
@@ -163,7 +191,7 @@ namespace RSP
 			std::memcpy(&mem[addr & 0x1FFC], &to_write, 4);
 		}
 		else {
-			WriteReg(addr, to_write);
+			active_write_reg(addr, to_write);
 		}
 	}
 
@@ -3,6 +3,8 @@ export module RSP:Operation;
 import :ScalarUnit;
 import :VectorUnit;
 
+import InstructionHistogram;
+import Serializer;
 import Util;
 
 import <array>;
@@ -11,18 +13,23 @@ import <concepts>;
 import <cstring>;
 import <format>;
 import <iostream>;
+import <ostream>;
 import <string>;
 import <string_view>;
+import <utility>;
 
 namespace RSP
 {
 	export
 	{
 		u8* GetPointerToMemory(u32 addr);
+		bool IsHalted();
 		void PowerOn();
 		u32 RdpReadCommand(u32 addr);
 		u64 RdpReadCommandByteswapped(u32 addr);
 		u64 Run(u64 rsp_cycles_to_run);
+		void StreamState(Serializer& serializer);
+		void WriteInstructionHistograms(std::ostream& os);
 
 		template<std::signed_integral Int>
 		Int ReadMemoryCpu(u32 addr);
@@ -45,20 +52,22 @@ namespace RSP
 	template<std::signed_integral Int> Int ReadDMEM(u32 addr);
 	template<std::signed_integral Int> void WriteDMEM(u32 addr, Int data);
 
-	bool in_branch_delay_slot;
-	bool jump_is_pending;
-	uint pc;
-	uint p_cycle_counter;
-	uint instructions_until_jump;
-	uint addr_to_jump_to;
+	thread_local bool in_branch_delay_slot;
+	thread_local bool jump_is_pending;
+	thread_local uint pc;
+	thread_local uint p_cycle_counter;
+	thread_local uint instructions_until_jump;
+	thread_local uint addr_to_jump_to;
 
-	constinit std::array<u8, 0x2000> mem; /* 0 - $FFF: data memory; $1000 - $1FFF: instruction memory */
+	thread_local InstructionHistogram scalar_instr_histogram, vector_instr_histogram;
+
+	constinit thread_local std::array<u8, 0x2000> mem; /* 0 - $FFF: data memory; $1000 - $1FFF: instruction memory */
 
 	constinit inline u8* const dmem = mem.data();
 	constinit inline u8* const imem = mem.data() + 0x1000;
 
 	/* Debugging */
-	u32 current_instr_pc;
-	std::string_view current_instr_name;
-	std::string current_instr_log_output;
+	thread_local u32 current_instr_pc;
+	thread_local std::string_view current_instr_name;
+	thread_local std::string current_instr_log_output;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 export module RSP;
 
+export import :Benchmarks;
 export import :Interface;
 export import :Operation;
 export import :ScalarUnit;
@@ -18,7 +18,7 @@ namespace RSP
 		auto base = instr_code >> 21 & 0x1F;
 		auto address = gpr[base] + offset;
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = std::format("{} {}, ${:X}", current_instr_name, rt, static_cast<std::make_unsigned<decltype(address)>::type>(address));
 		}
 
@@ -78,7 +78,7 @@ namespace RSP
 		auto base = instr_code >> 21 & 0x1F;
 		auto address = gpr[base] + offset;
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = std::format("{} {}, ${:X}", current_instr_name, rt, static_cast<std::make_unsigned<decltype(address)>::type>(address));
 		}
 
@@ -136,7 +136,7 @@ namespace RSP
 				return s16(instr_code & 0xFFFF);
 		}();
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = [&] {
 				if constexpr (instr == LUI)
 					return std::format("{} {}, ${:X}", current_instr_name, rt, immediate);
@@ -208,7 +208,7 @@ namespace RSP
 		auto rt = instr_code >> 16 & 0x1F;
 		auto rs = instr_code >> 21 & 0x1F;
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = std::format("{} {}, {}, {}", current_instr_name, rd, rs, rt);
 		}
 
@@ -278,7 +278,7 @@ namespace RSP
 		auto rt = instr_code >> 16 & 0x1F;
 		auto rs = instr_code >> 21 & 0x1F;
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = [&] {
 				if (instr_code == 0)
 					return std::string("NOP");
@@ -362,14 +362,14 @@ namespace RSP
 			u32 target = [&] {
 				if constexpr (instr == J || instr == JAL) {
 					u32 target = (instr_code & 0x3FF) << 2;
-					if constexpr (log_rsp_instructions) {
+					if constexpr (format_rsp_instructions) {
 						current_instr_log_output = std::format("{} ${:X}", current_instr_name, target);
 					}
 					return target;
 				}
 				else if constexpr (instr == JR || instr == JALR) {
 					auto rs = instr_code >> 21 & 0x1F;
-					if constexpr (log_rsp_instructions) {
+					if constexpr (format_rsp_instructions) {
 						current_instr_log_output = std::format("{} {}", current_instr_name, rs);
 					}
 					return gpr[rs] & 0xFFC;
@@ -401,7 +401,7 @@ namespace RSP
 		auto rt = instr_code >> 16 & 0x1F;
 		auto rs = instr_code >> 21 & 0x1F;
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = [&] {
 				s16 offset = instr_code & 0xFFFF;
 				if constexpr (instr == BEQ || instr == BNE)
@@ -450,19 +450,19 @@ namespace RSP
 		auto reg_addr = (rd & 7) << 2;
 		bool rdp_reg = rd & 8;
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = std::format("{} {}, {}", current_instr_name, rt, rd);
 		}
 
 		if constexpr (instr == MFC0) {
 			/* Move From System Control Coprocessor */
-			if (rdp_reg) gpr.Set(rt, ::RDP::ReadReg(reg_addr));
-			else         gpr.Set(rt, ::RSP::ReadReg(reg_addr));
+			if (rdp_reg) gpr.Set(rt, active_rdp_read_reg(reg_addr));
+			else         gpr.Set(rt, active_read_reg(reg_addr));
 		}
 		else if constexpr (instr == MTC0) {
 			/* Move To System Control Coprocessor */
-			if (rdp_reg) ::RDP::WriteReg(reg_addr, gpr[rt]);
-			else         ::RSP::WriteReg(reg_addr, gpr[rt]);
+			if (rdp_reg) active_rdp_write_reg(reg_addr, gpr[rt]);
+			else         active_write_reg(reg_addr, gpr[rt]);
 		}
 		else {
 			static_assert(AlwaysFalse<instr>, "\"RSP Move\" template function called, but no matching move instruction was found.");
@@ -474,7 +474,7 @@ namespace RSP
 
 	void Break()
 	{
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = "BREAK";
 		}
 		sp.status.halted = sp.status.broke = true;
@@ -48,7 +48,7 @@ namespace RSP
 	template<ScalarInstruction> void Move(u32 instr_code);
 	void Break();
 
-	class GPR /* scalar general-purpose registers */
+	thread_local class GPR /* scalar general-purpose registers */
 	{
 		std::array<s32, 32> gpr{};
 	public:
@@ -68,5 +68,5 @@ namespace RSP
 		}
 	} gpr{};
 
-	bool ll_bit; /* Read from / written to by load linked and store conditional instructions. */
+	thread_local bool ll_bit; /* Read from / written to by load linked and store conditional instructions. */
 }
\ No newline at end of file
@@ -181,7 +181,7 @@ namespace RSP
 				}
 			}
 
-			if constexpr (log_rsp_instructions) {
+			if constexpr (format_rsp_instructions) {
 				current_instr_log_output = std::format("{} {} e{}, ${:X}",
 					current_instr_name, vt, element, MakeUnsigned(addr));
 			}
@@ -195,7 +195,7 @@ namespace RSP
 				dmem[addr + i & 0xFFF] = *(vpr_src + ((element + i ^ 1) & 0xF));
 			}
 
-			if constexpr (log_rsp_instructions) {
+			if constexpr (format_rsp_instructions) {
 				current_instr_log_output = std::format("{} {} e{}, ${:X}",
 					current_instr_name, vt, element, MakeUnsigned(addr));
 			}
@@ -229,7 +229,7 @@ namespace RSP
 				}
 			}
 
-			if constexpr (log_rsp_instructions) {
+			if constexpr (format_rsp_instructions) {
 				current_instr_log_output = std::format("{} {} e{}, ${:X}",
 					current_instr_name, vt, element, MakeUnsigned(addr));
 			}
@@ -243,7 +243,7 @@ namespace RSP
 			u8* vpr_dst = (u8*)(&vpr[vt]);
 			u32 addr = gpr[base] + offset * 16;
 
-			if constexpr (log_rsp_instructions) {
+			if constexpr (format_rsp_instructions) {
 				current_instr_log_output = std::format("{} {} e{}, ${:X}",
 					current_instr_name, vt, element, MakeUnsigned(addr));
 			}
@@ -272,7 +272,7 @@ namespace RSP
 			const auto reg_base = vt & 0x18;
 			auto reg_off = element >> 1;
 
-			if constexpr (log_rsp_instructions) {
+			if constexpr (format_rsp_instructions) {
 				//current_instr_log_output = std::format("LTV {} e{}, ${:X}",
 				//	reg_base, MakeUnsigned(addr));
 			}
@@ -317,7 +317,7 @@ namespace RSP
 				CopyNextByte();
 			}
 
-			if constexpr (log_rsp_instructions) {
+			if constexpr (format_rsp_instructions) {
 				current_instr_log_output = std::format("STV {} e{}, ${:X}",
 					base_reg, element, MakeUnsigned(addr));
 			}
@@ -333,7 +333,7 @@ namespace RSP
 			const u8* vpr_src = (u8*)(&vpr[vt]);
 			auto addr = gpr[base] + offset * 16;
 
-			if constexpr (log_rsp_instructions) {
+			if constexpr (format_rsp_instructions) {
 				current_instr_log_output = std::format("{} {} e{}, ${:X}",
 					current_instr_name, vt, element, MakeUnsigned(addr));
 			}
@@ -357,7 +357,7 @@ namespace RSP
 			u8* vpr_dst = (u8*)(&vpr[vt]);
 			auto addr = gpr[base] + offset * 16;
 
-			if constexpr (log_rsp_instructions) {
+			if constexpr (format_rsp_instructions) {
 				current_instr_log_output = std::format("LWV {} e{}, ${:X}",
 					vt, element, MakeUnsigned(addr));
 			}
@@ -371,7 +371,7 @@ namespace RSP
 			u8* vpr_src = (u8*)(&vpr[vt]);
 			auto addr = gpr[base] + offset * 16;
 
-			if constexpr (log_rsp_instructions) {
+			if constexpr (format_rsp_instructions) {
 				current_instr_log_output = std::format("SWV {} e{}, ${:X}",
 					vt, element, MakeUnsigned(addr));
 			}
@@ -403,7 +403,7 @@ namespace RSP
 		auto vs = instr_code >> 11 & 0x1F;
 		auto rt = instr_code >> 16 & 0x1F;
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = std::format("{} GPR[{}] VPR[{}] e{}",
 				current_instr_name, rt, vs, element);
 		}
@@ -483,7 +483,7 @@ namespace RSP
 		}
 
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = [&] {
 				if constexpr (instr == VNOP) {
 					return current_instr_name;
@@ -614,7 +614,7 @@ namespace RSP
 		auto vt = instr_code >> 16 & 0x1F;
 		auto element = instr_code >> 21 & 0xF;
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = std::format("{} {} {} {} e{}",
 				current_instr_name, vd, vs, vt, element);
 		}
@@ -925,7 +925,7 @@ namespace RSP
 		auto vt = instr_code >> 16 & 0x1F;
 		auto element = instr_code >> 21 & 0xF;
 
-		if constexpr (log_rsp_instructions) {
+		if constexpr (format_rsp_instructions) {
 			current_instr_log_output = std::format("{} {} {} {} e{}",
 				current_instr_name, vd, vs, vt, element);
 		}
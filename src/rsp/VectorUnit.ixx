@@ -60,7 +60,7 @@ namespace RSP
 	template<VectorInstruction> __m128i ClampUnsigned(__m128i low, __m128i high);
 	__m128i GetVTBroadcast(uint vt, uint element);
 
-	struct Accumulator {
+	thread_local struct Accumulator {
 		__m128i low;
 		__m128i mid;
 		__m128i high;
@@ -90,10 +90,10 @@ namespace RSP
 		_mm_set1_epi16(0x0F'0E)  /* 7,7,7,7,7,7,7,7 */
 	};
 
-	s16 div_out, div_in, div_dp;
+	thread_local s16 div_out, div_in, div_dp;
 
-	std::array<__m128i, 32> vpr; /* SIMD registers; eight 16-bit lanes */
-	std::array<ControlRegister, 3> ctrl_reg; /* vco, vcc, vce. vce is actually only 8-bits */
+	thread_local std::array<__m128i, 32> vpr; /* SIMD registers; eight 16-bit lanes */
+	thread_local std::array<ControlRegister, 3> ctrl_reg; /* vco, vcc, vce. vce is actually only 8-bits */
 
 	constexpr std::array<s16, 512> rcp_rom = {
 		0xFFFF, 0xFF00, 0xFE01, 0xFD04, 0xFC07, 0xFB0C, 0xFA11, 0xF918, 0xF81F, 0xF727, 0xF631, 0xF53B, 0xF446, 0xF352, 0xF25F, 0xF16D,
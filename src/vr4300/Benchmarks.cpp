@@ -0,0 +1,78 @@
+module VR4300:Benchmarks;
+
+import :Cache;
+import :COP0;
+import :Exceptions;
+import :MMU;
+
+import Bench;
+
+namespace VR4300
+{
+	void FillTlb(bool matching)
+	{
+		for (u32 i = 0; i < tlb_entries.size(); ++i) {
+			cop0.page_mask = 0;
+			cop0.entry_hi = {};
+			cop0.entry_hi.vpn2 = matching ? i : 0x07FF'FFFF - i;
+			for (u32 j = 0; j < 2; ++j) {
+				cop0.entry_lo[j] = {};
+				cop0.entry_lo[j].g = cop0.entry_lo[j].v = cop0.entry_lo[j].d = 1;
+				cop0.entry_lo[j].pfn = 2 * i + j;
+			}
+			tlb_entries[i].Write();
+		}
+	}
+
+
+	void InvalidateCaches()
+	{
+		for (DCacheLine& line : d_cache) {
+			line.valid = line.dirty = false;
+		}
+		for (ICacheLine& line : i_cache) {
+			line.valid = false;
+		}
+	}
+
+
+	void RunBenchmarks()
+	{
+		/* Hits are spread over all 32 entries, so that the linear search is measured at its average depth */
+		FillTlb(true);
+		Bench::Measure("VR4300 TLB lookup, hit", [](u64 i) {
+			Bench::Consume(VirtualToPhysicalAddressTlb<MemOp::Read>(i % 32 << 13 | i * 4 & 0x1FFC));
+		});
+		FillTlb(false);
+		Bench::Measure("VR4300 TLB lookup, miss", [](u64 i) {
+			Bench::Consume(VirtualToPhysicalAddressTlb<MemOp::Read>((i & 0xFFFF) << 13));
+			exception_has_occurred = false;
+		});
+		InitializeMMU();
+
+		/* Hits stay within the size of the cache. Misses walk all lines with a new tag every pass over them,
+		   so that every access refills its line (and, for writes, writes back the previous contents). */
+		InvalidateCaches();
+		Bench::Measure("VR4300 D-cache read, hit", [](u64 i) {
+			Bench::Consume(ReadCacheableArea<s32, MemOp::Read>(u32(i * 4 & 0x1FFC)));
+		});
+		Bench::Measure("VR4300 D-cache read, miss", [](u64 i) {
+			Bench::Consume(ReadCacheableArea<s32, MemOp::Read>(u32((i >> 9 & 0x1FF) << 13 | (i & 0x1FF) << 4)));
+		});
+		InvalidateCaches();
+		Bench::Measure("VR4300 D-cache write, hit", [](u64 i) {
+			WriteCacheableArea<4>(u32(i * 4 & 0x1FFC), s64(i));
+		});
+		Bench::Measure("VR4300 D-cache write, miss", [](u64 i) {
+			WriteCacheableArea<4>(u32((i >> 9 & 0x1FF) << 13 | (i & 0x1FF) << 4), s64(i));
+		});
+		InvalidateCaches();
+		Bench::Measure("VR4300 I-cache fetch, hit", [](u64 i) {
+			Bench::Consume(ReadCacheableArea<s32, MemOp::InstrFetch>(u32(i * 4 & 0x3FFC)));
+		});
+		Bench::Measure("VR4300 I-cache fetch, miss", [](u64 i) {
+			Bench::Consume(ReadCacheableArea<s32, MemOp::InstrFetch>(u32((i >> 9 & 0xFF) << 14 | (i & 0x1FF) << 5)));
+		});
+		InvalidateCaches();
+	}
+}
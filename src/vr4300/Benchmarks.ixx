@@ -0,0 +1,14 @@
+export module VR4300:Benchmarks;
+
+import Util;
+
+namespace VR4300
+{
+	export
+	{
+		void RunBenchmarks(); /* see Bench; clobbers the TLB and the caches */
+	}
+
+	void FillTlb(bool matching); /* 'matching': entry i maps virtual page pair i, else no entry maps low addresses */
+	void InvalidateCaches();
+}
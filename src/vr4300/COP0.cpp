@@ -34,6 +34,7 @@ namespace VR4300
 	void Cop0Registers::OnWriteToStatus()
 	{
 		SetActiveVirtualToPhysicalFunctions();
+		SetActiveCop1DecodeFunctions();
 		CheckInterrupts();
 	}
 
@@ -60,7 +60,7 @@ namespace VR4300
 	constexpr uint cop0_index_error_epc = 30;
 
 	/* TODO: for registers that contain only one field, make them simple u32/u64, not structs */
-	struct Cop0Registers {
+	thread_local struct Cop0Registers {
 		struct { /* (0) */
 			u32 value : 6; /* Index to the TLB entry affected by the TLB Read (TLBR) and TLB Write (TLBW) instructions. */
 			u32 : 25;
@@ -230,7 +230,7 @@ namespace VR4300
 	} cop0;
 
 	/* Used to generate random numbers in the interval [wired, 31], when the 'random' register is read. */
-	class RandomGenerator
+	thread_local class RandomGenerator
 	{
 		std::random_device rd;  // Will be used to obtain a seed for the random number engine
 		std::mt19937 gen{ rd() }; // Standard mersenne_twister_engine seeded with rd()
@@ -41,32 +41,34 @@ namespace VR4300
 	}
 
 
-	template<FpuNumericType T>
+	template<FpuNumericType T, bool fr>
 	T FGR::Get(size_t index) const
 	{
 		if constexpr (sizeof(T) == 4) {
 			u32 data = [&] {
-				if (cop0.status.fr || !(index & 1)) return u32(fpr[index]);
+				if constexpr (fr) return u32(fpr[index]);
+				else if (!(index & 1)) return u32(fpr[index]);
 				else return u32(fpr[index & ~1] >> 32);
 			}();
 			return std::bit_cast<T>(data);
 		}
 		else {
-			if (!cop0.status.fr) index &= ~1;
+			if constexpr (!fr) index &= ~1;
 			return std::bit_cast<T>(fpr[index]);
 		}
 	}
 
 
-	template<FpuNumericType T>
+	template<FpuNumericType T, bool fr>
 	void FGR::Set(size_t index, T value)
 	{
 		if constexpr (sizeof(T) == 4) {
-			if (cop0.status.fr || !(index & 1)) std::memcpy(&fpr[index], &value, 4);
+			if constexpr (fr) std::memcpy(&fpr[index], &value, 4);
+			else if (!(index & 1)) std::memcpy(&fpr[index], &value, 4);
 			else std::memcpy((u8*)(&fpr[index & ~1]) + 4, &value, 4);
 		}
 		else {
-			if (!cop0.status.fr) index &= ~1;
+			if constexpr (!fr) index &= ~1;
 			fpr[index] = std::bit_cast<s64>(value);
 		}
 	}
@@ -275,7 +277,7 @@ namespace VR4300
 	}
 
 
-	template<Cop1Instruction instr>
+	template<Cop1Instruction instr, bool fr>
 	void FpuLoad(u32 instr_code)
 	{
 		if (!cop0.status.cu1) {
@@ -291,7 +293,7 @@ namespace VR4300
 		auto base = instr_code >> 21 & 0x1F;
 		auto addr = gpr[base] + offset;
 
-		if constexpr (log_cpu_instructions) {
+		if constexpr (format_cpu_instructions) {
 			current_instr_log_output = std::format("{} {}, ${:X}", current_instr_name, ft, static_cast<std::make_unsigned<decltype(addr)>::type>(addr));
 		}
 
@@ -304,12 +306,12 @@ namespace VR4300
 		AdvancePipeline(1);
 
 		if (!exception_has_occurred) {
-			fpr.Set(ft, result);
+			fpr.Set<decltype(result), fr>(ft, result);
 		}
 	}
 
 
-	template<Cop1Instruction instr>
+	template<Cop1Instruction instr, bool fr>
 	void FpuStore(u32 instr_code)
 	{
 		if (!cop0.status.cu1) {
@@ -325,19 +327,19 @@ namespace VR4300
 		auto base = instr_code >> 21 & 0x1F;
 		auto addr = gpr[base] + offset;
 
-		if constexpr (log_cpu_instructions) {
+		if constexpr (format_cpu_instructions) {
 			current_instr_log_output = std::format("{} {}, ${:X}", current_instr_name, ft, static_cast<std::make_unsigned<decltype(addr)>::type>(addr));
 		}
 
-		     if constexpr (instr == SWC1) WriteVirtual<4>(addr, fpr.Get<s32>(ft));
-		else if constexpr (instr == SDC1) WriteVirtual<4>(addr, fpr.Get<s64>(ft));
+		     if constexpr (instr == SWC1) WriteVirtual<4>(addr, fpr.Get<s32, fr>(ft));
+		else if constexpr (instr == SDC1) WriteVirtual<4>(addr, fpr.Get<s64, fr>(ft));
 		else static_assert(AlwaysFalse<instr>);
 
 		AdvancePipeline(1);
 	}
 
 
-	template<Cop1Instruction instr>
+	template<Cop1Instruction instr, bool fr>
 	void FpuMove(u32 instr_code)
 	{
 		using enum Cop1Instruction;
@@ -350,19 +352,19 @@ namespace VR4300
 		auto fs = instr_code >> 11 & 0x1F;
 		auto rt = instr_code >> 16 & 0x1F;
 
-		if constexpr (log_cpu_instructions) {
+		if constexpr (format_cpu_instructions) {
 			current_instr_log_output = std::format("{} {}, {}", current_instr_name, rt, fs);
 		}
 
 		if constexpr (instr == MTC1) {
 			/* Move Word To FPU;
 			   Transfers the contents of CPU general purpose register rt to FPU general purpose register fs. */
-			fpr.Set<s32>(fs, s32(gpr[rt]));
+			fpr.Set<s32, fr>(fs, s32(gpr[rt]));
 		}
 		else if constexpr (instr == MFC1) {
 			/* Move Word From FPU;
 			   Transfers the contents of FPU general purpose register fs to CPU general purpose register rt. */
-			gpr.Set(rt, u64(fpr.Get<s32>(fs)));
+			gpr.Set(rt, u64(fpr.Get<s32, fr>(fs)));
 		}
 		else if constexpr (instr == CTC1) {
 			/* Move Control Word To FPU;
@@ -377,12 +379,12 @@ namespace VR4300
 		else if constexpr (instr == DMTC1) {
 			/* Doubleword Move To FPU;
 			   Transfers the contents of CPU general purpose register rt to FPU general purpose register fs. */
-			fpr.Set<s64>(fs, s64(gpr[rt]));
+			fpr.Set<s64, fr>(fs, s64(gpr[rt]));
 		}
 		else if constexpr (instr == DMFC1) {
 			/* Doubleword Move From FPU;
 			   Transfers the contents of FPU general purpose register fs to CPU general purpose register rt. */
-			gpr.Set(rt, fpr.Get<s64>(fs));
+			gpr.Set(rt, fpr.Get<s64, fr>(fs));
 		}
 		else if constexpr (instr == DCFC1 || instr == DCTC1) {
 			ClearAllExceptions();
@@ -397,7 +399,7 @@ namespace VR4300
 	}
 
 
-	template<Cop1Instruction instr>
+	template<Cop1Instruction instr, bool fr>
 	void FpuConvert(u32 instr_code)
 	{
 		if (!cop0.status.cu1) {
@@ -433,7 +435,7 @@ namespace VR4300
 		auto fs = instr_code >> 11 & 0x1F;
 		auto fmt = instr_code >> 21 & 0x1F;
 
-		if constexpr (log_cpu_instructions) {
+		if constexpr (format_cpu_instructions) {
 			current_instr_log_output = std::format("{}.{} {}, {}", current_instr_name, FmtToChar(fmt), fd, fs);
 		}
 
@@ -462,7 +464,7 @@ namespace VR4300
 						SignalException<Exception::FloatingPoint>();
 						return;
 					}
-					From source = fpr.Get<From>(fs);
+					From source = fpr.Get<From, fr>(fs);
 					if constexpr (std::floating_point<From>) {
 						if (!IsValidInput(source)) return;
 					}
@@ -484,14 +486,14 @@ namespace VR4300
 					}
 					if constexpr (std::floating_point<To>) {
 						if (!exc_raised && IsValidOutput(conv)) {
-							fpr.Set<To>(fd, conv);
+							fpr.Set<To, fr>(fd, conv);
 						}
 					}
 					else if (exc_raised) {
 						SignalException<Exception::FloatingPoint>();
 					}
 					else {
-						fpr.Set<To>(fd, conv);
+						fpr.Set<To, fr>(fd, conv);
 					}
 				};
 				if constexpr (instr == CVT_S) INVOKE(Convert, InputType, f32);
@@ -517,7 +519,7 @@ namespace VR4300
 
 			   /* Interpret the source operand (as a float), and round it to an integer (s32 or s64). */
 			auto Round = [&] <std::floating_point InputFloat, std::signed_integral OutputInt> {
-				InputFloat source = fpr.Get<InputFloat>(fs);
+				InputFloat source = fpr.Get<InputFloat, fr>(fs);
 
 				OutputInt result = [&] {
 					if constexpr (OneOf(instr, ROUND_W, ROUND_L)) return OutputInt(std::nearbyint(source));
@@ -530,10 +532,10 @@ namespace VR4300
 
 				/* If the invalid operation exception occurs, but the exception is not enabled, return INT_MAX */
 				if (std::fetestexcept(FE_INVALID) && !fcr31.enable_inexact) {
-					fpr.Set<OutputInt>(fd, std::numeric_limits<OutputInt>::max());
+					fpr.Set<OutputInt, fr>(fd, std::numeric_limits<OutputInt>::max());
 				}
 				else {
-					fpr.Set<OutputInt>(fd, result);
+					fpr.Set<OutputInt, fr>(fd, result);
 				}
 			};
 
@@ -571,7 +573,7 @@ namespace VR4300
 	}
 
 
-	template<Cop1Instruction instr>
+	template<Cop1Instruction instr, bool fr>
 	void FpuCompute(u32 instr_code)
 	{
 		if (!cop0.status.cu1) {
@@ -589,17 +591,17 @@ namespace VR4300
 		auto fmt = instr_code >> 21 & 0x1F;
 
 		if constexpr (OneOf(instr, ADD, SUB, MUL, DIV)) {
-			if constexpr (log_cpu_instructions) {
+			if constexpr (format_cpu_instructions) {
 				current_instr_log_output = std::format("{}.{} {}, {}, {}", current_instr_name, FmtToChar(fmt), fd, fs, ft);
 			}
 
 			auto Compute = [&] <std::floating_point Float> {
-				Float op1 = fpr.Get<Float>(fs);
+				Float op1 = fpr.Get<Float, fr>(fs);
 				if (!IsValidInput(op1)) {
 					AdvancePipeline(2);
 					return;
 				}
-				Float op2 = fpr.Get<Float>(ft);
+				Float op2 = fpr.Get<Float, fr>(ft);
 				if (!IsValidInput(op2)) {
 					AdvancePipeline(2);
 					return;
@@ -626,7 +628,7 @@ namespace VR4300
 				}();
 				bool exc_raised = TestAllExceptions();
 				if (!exc_raised && IsValidOutput(result)) {
-					fpr.Set<Float>(fd, result);
+					fpr.Set<Float, fr>(fd, result);
 				}
 			};
 
@@ -637,12 +639,12 @@ namespace VR4300
 			}
 		}
 		else if constexpr (OneOf(instr, ABS, MOV, NEG, SQRT)) {
-			if constexpr (log_cpu_instructions) {
+			if constexpr (format_cpu_instructions) {
 				current_instr_log_output = std::format("{}.{} {}, {}", current_instr_name, FmtToChar(fmt), fd, fs);
 			}
 
 			auto Compute = [&] <std::floating_point Float> {
-				Float op = fpr.Get<Float>(fs);
+				Float op = fpr.Get<Float, fr>(fs);
 				if constexpr (instr != MOV) {
 					if (!IsValidInput(op)) {
 						AdvancePipeline(2);
@@ -669,12 +671,12 @@ namespace VR4300
 					}
 				}();
 				if constexpr (instr == MOV) {
-					fpr.Set<Float>(fd, result);
+					fpr.Set<Float, fr>(fd, result);
 				}
 				else {
 					bool exc_raised = TestAllExceptions();
 					if (!exc_raised && IsValidOutput(result)) {
-						fpr.Set<Float>(fd, result);
+						fpr.Set<Float, fr>(fd, result);
 					}
 				}
 			};
@@ -720,7 +722,7 @@ namespace VR4300
 		   If the FPU condition line is false, branches to the target address (delay of one instruction).
 		   If conditional branch does not take place, the instruction in the delay slot is invalidated. */
 
-		if constexpr (log_cpu_instructions) {
+		if constexpr (format_cpu_instructions) {
 			current_instr_log_output = std::format("{} ${:X}", current_instr_name, s16(instr_code));
 		}
 
@@ -742,6 +744,7 @@ namespace VR4300
 	}
 
 
+	template<bool fr>
 	void FpuCompare(u32 instr_code)
 	{
 		/* Floating-point Compare;
@@ -761,7 +764,7 @@ namespace VR4300
 		auto ft = instr_code >> 16 & 0x1F;
 		auto fmt = instr_code >> 21 & 0x1F;
 
-		if constexpr (log_cpu_instructions) {
+		if constexpr (format_cpu_instructions) {
 			current_instr_log_output = std::format("C.{}.{} {}, {}", compare_cond_strings[cond], FmtToChar(fmt), fs, ft);
 		}
 
@@ -777,8 +780,8 @@ namespace VR4300
 				}
 				else return true;
 			};
-			Float op1 = fpr.Get<Float>(fs);
-			Float op2 = fpr.Get<Float>(ft);
+			Float op1 = fpr.Get<Float, fr>(fs);
+			Float op2 = fpr.Get<Float, fr>(ft);
 			if (std::isnan(op1) || std::isnan(op2)) {
 				if (!IsValidInput(op1)) {
 					AdvancePipeline(2);
@@ -806,55 +809,98 @@ namespace VR4300
 	template bool IsQuietNan<f32>(f32);
 	template bool IsQuietNan<f64>(f64);
 
-	template void FpuLoad<Cop1Instruction::LWC1>(u32);
-	template void FpuLoad<Cop1Instruction::LDC1>(u32);
-
-	template void FpuStore<Cop1Instruction::SWC1>(u32);
-	template void FpuStore<Cop1Instruction::SDC1>(u32);
-
-	template void FpuMove<Cop1Instruction::MTC1>(u32);
-	template void FpuMove<Cop1Instruction::MFC1>(u32);
-	template void FpuMove<Cop1Instruction::CTC1>(u32);
-	template void FpuMove<Cop1Instruction::CFC1>(u32);
-	template void FpuMove<Cop1Instruction::DMTC1>(u32);
-	template void FpuMove<Cop1Instruction::DMFC1>(u32);
-	template void FpuMove<Cop1Instruction::DCFC1>(u32);
-	template void FpuMove<Cop1Instruction::DCTC1>(u32);
-
-	template void FpuConvert<Cop1Instruction::CVT_S>(u32);
-	template void FpuConvert<Cop1Instruction::CVT_D>(u32);
-	template void FpuConvert<Cop1Instruction::CVT_L>(u32);
-	template void FpuConvert<Cop1Instruction::CVT_W>(u32);
-	template void FpuConvert<Cop1Instruction::ROUND_L>(u32);
-	template void FpuConvert<Cop1Instruction::ROUND_W>(u32);
-	template void FpuConvert<Cop1Instruction::TRUNC_L>(u32);
-	template void FpuConvert<Cop1Instruction::TRUNC_W>(u32);
-	template void FpuConvert<Cop1Instruction::CEIL_L>(u32);
-	template void FpuConvert<Cop1Instruction::CEIL_W>(u32);
-	template void FpuConvert<Cop1Instruction::FLOOR_L>(u32);
-	template void FpuConvert<Cop1Instruction::FLOOR_W>(u32);
-
-	template void FpuCompute<Cop1Instruction::ADD>(u32);
-	template void FpuCompute<Cop1Instruction::SUB>(u32);
-	template void FpuCompute<Cop1Instruction::MUL>(u32);
-	template void FpuCompute<Cop1Instruction::DIV>(u32);
-	template void FpuCompute<Cop1Instruction::ABS>(u32);
-	template void FpuCompute<Cop1Instruction::MOV>(u32);
-	template void FpuCompute<Cop1Instruction::NEG>(u32);
-	template void FpuCompute<Cop1Instruction::SQRT>(u32);
+	template void FpuLoad<Cop1Instruction::LWC1, false>(u32);
+	template void FpuLoad<Cop1Instruction::LWC1, true>(u32);
+	template void FpuLoad<Cop1Instruction::LDC1, false>(u32);
+	template void FpuLoad<Cop1Instruction::LDC1, true>(u32);
+
+	template void FpuStore<Cop1Instruction::SWC1, false>(u32);
+	template void FpuStore<Cop1Instruction::SWC1, true>(u32);
+	template void FpuStore<Cop1Instruction::SDC1, false>(u32);
+	template void FpuStore<Cop1Instruction::SDC1, true>(u32);
+
+	template void FpuMove<Cop1Instruction::MTC1, false>(u32);
+	template void FpuMove<Cop1Instruction::MTC1, true>(u32);
+	template void FpuMove<Cop1Instruction::MFC1, false>(u32);
+	template void FpuMove<Cop1Instruction::MFC1, true>(u32);
+	template void FpuMove<Cop1Instruction::CTC1, false>(u32);
+	template void FpuMove<Cop1Instruction::CTC1, true>(u32);
+	template void FpuMove<Cop1Instruction::CFC1, false>(u32);
+	template void FpuMove<Cop1Instruction::CFC1, true>(u32);
+	template void FpuMove<Cop1Instruction::DMTC1, false>(u32);
+	template void FpuMove<Cop1Instruction::DMTC1, true>(u32);
+	template void FpuMove<Cop1Instruction::DMFC1, false>(u32);
+	template void FpuMove<Cop1Instruction::DMFC1, true>(u32);
+	template void FpuMove<Cop1Instruction::DCFC1, false>(u32);
+	template void FpuMove<Cop1Instruction::DCFC1, true>(u32);
+	template void FpuMove<Cop1Instruction::DCTC1, false>(u32);
+	template void FpuMove<Cop1Instruction::DCTC1, true>(u32);
+
+	template void FpuConvert<Cop1Instruction::CVT_S, false>(u32);
+	template void FpuConvert<Cop1Instruction::CVT_S, true>(u32);
+	template void FpuConvert<Cop1Instruction::CVT_D, false>(u32);
+	template void FpuConvert<Cop1Instruction::CVT_D, true>(u32);
+	template void FpuConvert<Cop1Instruction::CVT_L, false>(u32);
+	template void FpuConvert<Cop1Instruction::CVT_L, true>(u32);
+	template void FpuConvert<Cop1Instruction::CVT_W, false>(u32);
+	template void FpuConvert<Cop1Instruction::CVT_W, true>(u32);
+	template void FpuConvert<Cop1Instruction::ROUND_L, false>(u32);
+	template void FpuConvert<Cop1Instruction::ROUND_L, true>(u32);
+	template void FpuConvert<Cop1Instruction::ROUND_W, false>(u32);
+	template void FpuConvert<Cop1Instruction::ROUND_W, true>(u32);
+	template void FpuConvert<Cop1Instruction::TRUNC_L, false>(u32);
+	template void FpuConvert<Cop1Instruction::TRUNC_L, true>(u32);
+	template void FpuConvert<Cop1Instruction::TRUNC_W, false>(u32);
+	template void FpuConvert<Cop1Instruction::TRUNC_W, true>(u32);
+	template void FpuConvert<Cop1Instruction::CEIL_L, false>(u32);
+	template void FpuConvert<Cop1Instruction::CEIL_L, true>(u32);
+	template void FpuConvert<Cop1Instruction::CEIL_W, false>(u32);
+	template void FpuConvert<Cop1Instruction::CEIL_W, true>(u32);
+	template void FpuConvert<Cop1Instruction::FLOOR_L, false>(u32);
+	template void FpuConvert<Cop1Instruction::FLOOR_L, true>(u32);
+	template void FpuConvert<Cop1Instruction::FLOOR_W, false>(u32);
+	template void FpuConvert<Cop1Instruction::FLOOR_W, true>(u32);
+
+	template void FpuCompute<Cop1Instruction::ADD, false>(u32);
+	template void FpuCompute<Cop1Instruction::ADD, true>(u32);
+	template void FpuCompute<Cop1Instruction::SUB, false>(u32);
+	template void FpuCompute<Cop1Instruction::SUB, true>(u32);
+	template void FpuCompute<Cop1Instruction::MUL, false>(u32);
+	template void FpuCompute<Cop1Instruction::MUL, true>(u32);
+	template void FpuCompute<Cop1Instruction::DIV, false>(u32);
+	template void FpuCompute<Cop1Instruction::DIV, true>(u32);
+	template void FpuCompute<Cop1Instruction::ABS, false>(u32);
+	template void FpuCompute<Cop1Instruction::ABS, true>(u32);
+	template void FpuCompute<Cop1Instruction::MOV, false>(u32);
+	template void FpuCompute<Cop1Instruction::MOV, true>(u32);
+	template void FpuCompute<Cop1Instruction::NEG, false>(u32);
+	template void FpuCompute<Cop1Instruction::NEG, true>(u32);
+	template void FpuCompute<Cop1Instruction::SQRT, false>(u32);
+	template void FpuCompute<Cop1Instruction::SQRT, true>(u32);
 
 	template void FpuBranch<Cop1Instruction::BC1T>(u32);
 	template void FpuBranch<Cop1Instruction::BC1F>(u32);
 	template void FpuBranch<Cop1Instruction::BC1TL>(u32);
 	template void FpuBranch<Cop1Instruction::BC1FL>(u32);
 
-	template s32 FGR::Get<s32>(size_t) const;
-	template s64 FGR::Get<s64>(size_t) const;
-	template f32 FGR::Get<f32>(size_t) const;
-	template f64 FGR::Get<f64>(size_t) const;
-
-	template void FGR::Set<s32>(size_t, s32);
-	template void FGR::Set<s64>(size_t, s64);
-	template void FGR::Set<f32>(size_t, f32);
-	template void FGR::Set<f64>(size_t, f64);
+	template void FpuCompare<false>(u32);
+	template void FpuCompare<true>(u32);
+
+	template s32 FGR::Get<s32, false>(size_t) const;
+	template s32 FGR::Get<s32, true>(size_t) const;
+	template s64 FGR::Get<s64, false>(size_t) const;
+	template s64 FGR::Get<s64, true>(size_t) const;
+	template f32 FGR::Get<f32, false>(size_t) const;
+	template f32 FGR::Get<f32, true>(size_t) const;
+	template f64 FGR::Get<f64, false>(size_t) const;
+	template f64 FGR::Get<f64, true>(size_t) const;
+
+	template void FGR::Set<s32, false>(size_t, s32);
+	template void FGR::Set<s32, true>(size_t, s32);
+	template void FGR::Set<s64, false>(size_t, s64);
+	template void FGR::Set<s64, true>(size_t, s64);
+	template void FGR::Set<f32, false>(size_t, f32);
+	template void FGR::Set<f32, true>(size_t, f32);
+	template void FGR::Set<f64, false>(size_t, f64);
+	template void FGR::Set<f64, true>(size_t, f64);
 }
\ No newline at end of file
@@ -45,14 +45,15 @@ namespace VR4300
 		InexactOp, Underflow, Overflow, DivByZero, InvalidOp, UnimplementedOp
 	};
 
-	/* COP1/FPU instructions */
-	template<Cop1Instruction> void FpuLoad(u32 instr_code);
-	template<Cop1Instruction> void FpuStore(u32 instr_code);
-	template<Cop1Instruction> void FpuMove(u32 instr_code);
-	template<Cop1Instruction> void FpuConvert(u32 instr_code);
-	template<Cop1Instruction> void FpuCompute(u32 instr_code);
+	/* COP1/FPU instructions. Those accessing the FGRs are instantiated once per value of cop0.status.fr;
+	   the decoder selects the set matching the current mode (see SetActiveCop1DecodeFunctions). */
+	template<Cop1Instruction, bool fr> void FpuLoad(u32 instr_code);
+	template<Cop1Instruction, bool fr> void FpuStore(u32 instr_code);
+	template<Cop1Instruction, bool fr> void FpuMove(u32 instr_code);
+	template<Cop1Instruction, bool fr> void FpuConvert(u32 instr_code);
+	template<Cop1Instruction, bool fr> void FpuCompute(u32 instr_code);
 	template<Cop1Instruction> void FpuBranch(u32 instr_code);
-	void FpuCompare(u32 instr_code);
+	template<bool fr> void FpuCompare(u32 instr_code);
 
 	void ClearAllExceptions();
 	template<std::floating_point Float> Float Flush(Float f);
@@ -71,7 +72,7 @@ namespace VR4300
 	template<bool ctc1 = false> bool TestAllExceptions();
 
 	/* Floating point control register #31 */
-	struct FCR31 {
+	thread_local struct FCR31 {
 		u32 rm : 2; /* Rounding mode */
 
 		u32 flag_inexact : 1;
@@ -101,15 +102,16 @@ namespace VR4300
 	} fcr31;
 
 	/* Floating point control registers. Only #0 and #31 are "valid", and #0 is read-only. */
-	struct FPUControl {
+	thread_local struct FPUControl {
 		u32 Get(size_t index) const;
 		void Set(size_t index, u32 value);
 	} fpu_control;
 
-	/* General-purpose floating point registers. */
-	struct FGR {
-		template<FpuNumericType T> T Get(size_t index) const;
-		template<FpuNumericType T> void Set(size_t index, T data);
+	/* General-purpose floating point registers. 'fr' is the value of cop0.status.fr
+	   (0: 16 registers, made up of even/odd pairs; 1: 32 registers). */
+	thread_local struct FGR {
+		template<FpuNumericType T, bool fr> T Get(size_t index) const;
+		template<FpuNumericType T, bool fr> void Set(size_t index, T data);
 	private:
 		std::array<s64, 32> fpr;
 	} fpr;
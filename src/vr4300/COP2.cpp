@@ -20,7 +20,7 @@ namespace VR4300
 	{
 		AdvancePipeline(1);
 
-		if constexpr (log_cpu_instructions) {
+		if constexpr (format_cpu_instructions) {
 			current_instr_log_output = std::format("{} {}", current_instr_name, rt);
 		}
 
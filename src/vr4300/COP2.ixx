@@ -15,5 +15,5 @@ namespace VR4300
 
 	void InitializeCop22();
 
-	u64 cop2_latch;
+	thread_local u64 cop2_latch;
 }
\ No newline at end of file
@@ -8,6 +8,7 @@ import :Recompiler;
 
 import BuildOptions;
 import Memory;
+import Profiler;
 
 #ifdef __has_builtin
 #if __has_builtin(__builtin_add_overflow)
@@ -991,6 +992,9 @@ namespace VR4300
 		if (!in_branch_delay_slot) {
 			u64 target = pc & 0xFFFF'FFFF'F000'0000 | imm26 << 2;
 			PrepareJump(target);
+			if constexpr (profile_guest) {
+				Profiler::OnCpuCall(u32(target), u32(pc + 4));
+			}
 		}
 		gpr.Set(31, 4 + (in_branch_delay_slot ? addr_to_jump_to : pc));
 		AdvancePipeline(1);
@@ -1006,6 +1010,11 @@ namespace VR4300
 			}
 			else {
 				PrepareJump(target);
+				if constexpr (profile_guest) {
+					if (rs == 31) {
+						Profiler::OnCpuReturn(u32(target));
+					}
+				}
 			}
 		}
 		AdvancePipeline(1);
@@ -1021,6 +1030,9 @@ namespace VR4300
 			}
 			else {
 				PrepareJump(target);
+				if constexpr (profile_guest) {
+					Profiler::OnCpuCall(u32(target), u32(pc + 4));
+				}
 			}
 		}
 		gpr.Set(rd, 4 + (in_branch_delay_slot ? addr_to_jump_to : pc));
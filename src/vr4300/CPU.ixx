@@ -81,7 +81,7 @@ namespace VR4300
 	void SYSCALL();
 	void BREAK();
 
-	class GPR
+	thread_local class GPR
 	{
 		std::array<s64, 32> gpr{};
 	public:
@@ -41,6 +41,6 @@ namespace VR4300
 	constexpr uint cache_hit_write_cycle_delay = 0;
 	constexpr uint cache_miss_cycle_delay = 0; /* Magic number gathered from ares / CEN64 */
 
-	std::array<DCacheLine, 512> d_cache; /* 8 KB */
-	std::array<ICacheLine, 512> i_cache; /* 16 KB */
+	thread_local std::array<DCacheLine, 512> d_cache; /* 8 KB */
+	thread_local std::array<ICacheLine, 512> i_cache; /* 16 KB */
 }
\ No newline at end of file
@@ -131,7 +131,7 @@ namespace VR4300
 
 	void HandleException()
 	{
-		if constexpr (log_cpu_exceptions) {
+		if (Log::IsEnabled(Log::Category::CpuExceptions)) {
 			Log::CpuException(ExceptionToString(occurred_exception));
 		}
 
@@ -149,6 +149,7 @@ namespace VR4300
 		pc = exception_vector;
 		in_branch_delay_slot = false;
 		jump_is_pending = false;
+		last_jump_pc = 0; /* an exception may return into the middle of an idle loop candidate */
 
 		exception_handler();
 	}
@@ -83,11 +83,11 @@ namespace VR4300
 	void TrapException();
 	void WatchException();
 
-	Exception occurred_exception;
-	bool exception_has_occurred = false;
-	int occurred_exception_priority = -1;
-	u64 exception_bad_virt_addr;
-	u64 exception_vector;
-	uint coprocessor_unusable_source; /* 0 if COP0 signaled the exception, 1 if COP1 did it. */
-	ExceptionHandler exception_handler;
+	thread_local Exception occurred_exception;
+	thread_local bool exception_has_occurred = false;
+	thread_local int occurred_exception_priority = -1;
+	thread_local u64 exception_bad_virt_addr;
+	thread_local u64 exception_vector;
+	thread_local uint coprocessor_unusable_source; /* 0 if COP0 signaled the exception, 1 if COP1 did it. */
+	thread_local ExceptionHandler exception_handler;
 }
\ No newline at end of file
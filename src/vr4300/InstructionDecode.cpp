@@ -11,33 +11,45 @@ import :Operation;
 import :Recompiler;
 
 import BuildOptions;
+import InstructionHistogram;
 import Log;
 import Util;
 
 
+#define COUNT_INSTR(HISTOGRAM, INSTR_CLASS, INSTR) { \
+	if constexpr (instruction_histograms) { \
+		static_assert(std::to_underlying(INSTR_CLASS::INSTR) < InstructionHistogram::max_instructions); \
+		HISTOGRAM.Increment(std::to_underlying(INSTR_CLASS::INSTR), #INSTR); } }
+
 #define EXEC_CPU_INSTR(INSTR) { \
 	if constexpr (log_cpu_instructions) \
 		current_instr_name = #INSTR; \
+	COUNT_INSTR(cpu_instr_histogram, CpuInstruction, INSTR); \
 	ExecuteCpuInstruction<CpuInstruction::INSTR>(); }
 
 #define EXEC_COP0_INSTR(INSTR) { \
 	if constexpr (log_cpu_instructions) \
 		current_instr_name = #INSTR; \
+	COUNT_INSTR(cop0_instr_histogram, Cop0Instruction, INSTR); \
 	ExecuteCop0Instruction<Cop0Instruction::INSTR>(); }
 
 #define EXEC_COP1_INSTR(INSTR) { \
 	if constexpr (log_cpu_instructions) \
 		current_instr_name = #INSTR; \
-	ExecuteCop1Instruction<Cop1Instruction::INSTR>(); }
+	COUNT_INSTR(cop1_instr_histogram, Cop1Instruction, INSTR); \
+	ExecuteCop1Instruction<Cop1Instruction::INSTR, fr>(); }
 
 #define EXEC_COP2_INSTR(INSTR) { \
 	if constexpr (log_cpu_instructions) \
 		current_instr_name = #INSTR; \
+	COUNT_INSTR(cop2_instr_histogram, Cop2Instruction, INSTR); \
 	ExecuteCop2Instruction<Cop2Instruction::INSTR>(); }
 
 #define LOG_INSTR(OUTPUT) { \
-	if constexpr (log_cpu_instructions) \
-		Log::CpuInstruction(last_instr_fetch_phys_addr, OUTPUT); }
+	if constexpr (format_cpu_instructions) \
+		Log::CpuInstruction(last_instr_fetch_phys_addr, OUTPUT); \
+	else if constexpr (log_cpu_instructions) \
+		Log::CpuInstruction(last_instr_fetch_phys_addr, current_instr_name, instr_code); }
 
 #define IMM16 (instr_code & 0xFFFF)
 #define IMM26 (instr_code & 0x3FF'FFFF)
@@ -48,7 +60,7 @@ import Util;
 
 namespace VR4300
 {
-	u32 instr_code;
+	thread_local u32 instr_code;
 
 
 	void DecodeExecuteCop0Instruction()
@@ -84,6 +96,7 @@ namespace VR4300
 	}
 
 
+	template<bool fr>
 	void DecodeExecuteCop1Instruction()
 	{
 		auto opcode = instr_code >> 21 & 0x1F;
@@ -153,6 +166,21 @@ namespace VR4300
 	}
 
 
+	template<bool fr>
+	void DecodeExecuteCop1LoadStoreInstruction()
+	{
+		auto opcode = instr_code >> 26;
+
+		switch (opcode) {
+		case 0b110101: EXEC_COP1_INSTR(LDC1); break;
+		case 0b110001: EXEC_COP1_INSTR(LWC1); break;
+		case 0b111101: EXEC_COP1_INSTR(SDC1); break;
+		case 0b111001: EXEC_COP1_INSTR(SWC1); break;
+		default: std::unreachable();
+		}
+	}
+
+
 	void DecodeExecuteCop2Instruction()
 	{
 		auto opcode = instr_code >> 21 & 0x1F;
@@ -197,7 +225,7 @@ namespace VR4300
 		case 0b000000: DecodeExecuteSpecialInstruction(); break;
 		case 0b000001: DecodeExecuteRegimmInstruction(); break;
 		case 0b010000: DecodeExecuteCop0Instruction(); break;
-		case 0b010001: DecodeExecuteCop1Instruction(); break;
+		case 0b010001: active_cop1_decode_fun(); break;
 		case 0b010010: DecodeExecuteCop2Instruction(); break;
 		case 0b010011: DecodeExecuteCOP3Instruction(); break;
 
@@ -251,10 +279,10 @@ namespace VR4300
 
 		case 0b101111: EXEC_CPU_INSTR(CACHE); break;
 
-		case 0b110101: EXEC_COP1_INSTR(LDC1); break;
-		case 0b110001: EXEC_COP1_INSTR(LWC1); break;
-		case 0b111101: EXEC_COP1_INSTR(SDC1); break;
-		case 0b111001: EXEC_COP1_INSTR(SWC1); break;
+		case 0b110101:
+		case 0b110001:
+		case 0b111101:
+		case 0b111001: active_cop1_load_store_decode_fun(); break;
 
 		default:
 			NotifyIllegalInstrCode(instr_code);
@@ -362,13 +390,26 @@ namespace VR4300
 	}
 
 
+	void SetActiveCop1DecodeFunctions()
+	{
+		if (cop0.status.fr) {
+			active_cop1_decode_fun = DecodeExecuteCop1Instruction<true>;
+			active_cop1_load_store_decode_fun = DecodeExecuteCop1LoadStoreInstruction<true>;
+		}
+		else {
+			active_cop1_decode_fun = DecodeExecuteCop1Instruction<false>;
+			active_cop1_load_store_decode_fun = DecodeExecuteCop1LoadStoreInstruction<false>;
+		}
+	}
+
+
 	template<CpuInstruction instr>
 	void ExecuteCpuInstruction()
 	{
 		static constexpr bool recompiler_breakup_block = [] {
 			using enum CpuInstruction;
-			return OneOf(instr, BEQ, BNE, BLEZ, BGTZ, BLTZ, BGEZ, BLTZAL, BGEZAL, BEQL, BNEL, BLEZL,
-				BGTZL, BLTZL, BGEZL, BLTZALL, BGEZALL, TGE, TGEU, TLT, TLTU, TEQ, TNE, TGEI, TGEIU,
+			return OneOf(instr, J, JAL, JR, JALR, BEQ, BNE, BLEZ, BGTZ, BLTZ, BGEZ, BLTZAL, BGEZAL, BEQL, BNEL,
+				BLEZL, BGTZL, BLTZL, BGEZL, BLTZALL, BGEZALL, TGE, TGEU, TLT, TLTU, TEQ, TNE, TGEI, TGEIU,
 				TLTI, TLTIU, TEQI, TNEI, BREAK, SYSCALL);
 		}();
 		if constexpr (recompile_cpu && recompiler_breakup_block) {
@@ -495,6 +536,9 @@ namespace VR4300
 		}
 		else {
 			LOG_INSTR(current_instr_name.data());
+			if constexpr (recompile_cpu && instr == Cop0Instruction::ERET) {
+				Recompiler::BreakupBlock();
+			}
 			if constexpr (instr == Cop0Instruction::TLBP)       TLBP();
 			else if constexpr (instr == Cop0Instruction::TLBR)  TLBR();
 			else if constexpr (instr == Cop0Instruction::TLBWI) TLBWI();
@@ -505,37 +549,40 @@ namespace VR4300
 	}
 
 
-	template<Cop1Instruction instr>
+	template<Cop1Instruction instr, bool fr>
 	void ExecuteCop1Instruction()
 	{
 		using enum Cop1Instruction;
 		if constexpr (OneOf(instr, LWC1, LDC1)) {
-			FpuLoad<instr>(instr_code);
+			FpuLoad<instr, fr>(instr_code);
 		}
 		else if constexpr (OneOf(instr, SWC1, SDC1)) {
-			FpuStore<instr>(instr_code);
+			FpuStore<instr, fr>(instr_code);
 		}
 		else if constexpr (OneOf(instr, MTC1, MFC1, CTC1, CFC1, DMTC1, DMFC1, DCFC1, DCTC1)) {
-			FpuMove<instr>(instr_code);
+			FpuMove<instr, fr>(instr_code);
 		}
 		else if constexpr (OneOf(instr, CVT_S, CVT_D, CVT_L, CVT_W, ROUND_L, ROUND_W, TRUNC_L, TRUNC_W, CEIL_L, CEIL_W, FLOOR_L, FLOOR_W)) {
-			FpuConvert<instr>(instr_code);
+			FpuConvert<instr, fr>(instr_code);
 		}
 		else if constexpr (OneOf(instr, ADD, SUB, MUL, DIV, ABS, MOV, NEG, SQRT)) {
-			FpuCompute<instr>(instr_code);
+			FpuCompute<instr, fr>(instr_code);
 		}
 		else if constexpr (OneOf(instr, BC1T, BC1F, BC1TL, BC1FL)) {
 			FpuBranch<instr>(instr_code);
 		}
 		else if constexpr (instr == C) {
-			FpuCompare(instr_code);
+			FpuCompare<fr>(instr_code);
 		}
 		else {
 			static_assert(AlwaysFalse<instr>);
 		}
-		if constexpr (log_cpu_instructions) {
+		if constexpr (format_cpu_instructions) {
 			Log::CpuInstruction(last_instr_fetch_phys_addr, current_instr_log_output);
 		}
+		else if constexpr (log_cpu_instructions) {
+			Log::CpuInstruction(last_instr_fetch_phys_addr, current_instr_name, instr_code);
+		}
 	}
 
 
@@ -549,8 +596,11 @@ namespace VR4300
 		else {
 			static_assert(AlwaysFalse<instr>);
 		}
-		if constexpr (log_cpu_instructions) {
+		if constexpr (format_cpu_instructions) {
 			Log::CpuInstruction(last_instr_fetch_phys_addr, current_instr_log_output);
 		}
+		else if constexpr (log_cpu_instructions) {
+			Log::CpuInstruction(last_instr_fetch_phys_addr, current_instr_name, instr_code);
+		}
 	}
 }
\ No newline at end of file
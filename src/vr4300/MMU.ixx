@@ -16,7 +16,7 @@ namespace VR4300
 {
 	using VirtualToPhysicalAddressFun = u32(*)(u64 /* in: v_addr */, bool& /* out: cached area? */);
 
-	enum class AddressingMode {
+	thread_local enum class AddressingMode {
 		_32bit, _64bit
 	} addressing_mode;
 
@@ -62,13 +62,13 @@ namespace VR4300
 	void InitializeMMU();
 	void SetActiveVirtualToPhysicalFunctions();
 
-	u32 last_physical_address_on_load;
+	thread_local u32 last_physical_address_on_load;
 
-	std::array<TlbEntry, 32> tlb_entries;
+	thread_local std::array<TlbEntry, 32> tlb_entries;
 
-	VirtualToPhysicalAddressFun active_virtual_to_physical_fun_read;
-	VirtualToPhysicalAddressFun active_virtual_to_physical_fun_write;
+	thread_local VirtualToPhysicalAddressFun active_virtual_to_physical_fun_read;
+	thread_local VirtualToPhysicalAddressFun active_virtual_to_physical_fun_write;
 
 	/* Used for logging. Set when memory is read during an instruction fetch. */
-	export u32 last_instr_fetch_phys_addr;
+	export thread_local u32 last_instr_fetch_phys_addr;
 }
\ No newline at end of file
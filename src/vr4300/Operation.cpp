@@ -1,13 +1,16 @@
 module VR4300:Operation;
 
+import :Cache;
 import :COP0;
 import :COP1;
+import :COP2;
 import :CPU;
 import :Exceptions;
 import :MMU;
 import :Recompiler;
 
 import BuildOptions;
+import Cart;
 import Log;
 import RDRAM;
 
@@ -48,6 +51,20 @@ namespace VR4300
 	}
 
 
+	void DetectIdleLoop(u64 branch_pc, u64 target_address)
+	{
+		/* Only analyze a backward branch once it has been taken twice in a row, i.e., once the whole
+		   loop body has been executed at least once without entering it from elsewhere. */
+		bool looped = branch_pc == last_jump_pc;
+		last_jump_pc = branch_pc;
+		if (!looped || target_address > branch_pc
+			|| (branch_pc - target_address) / 4 + 2 > max_idle_loop_instructions) {
+			return;
+		}
+		idle_loop_detected = IsIdleLoop(branch_pc, target_address);
+	}
+
+
 	void FetchDecodeExecuteInstruction()
 	{
 		u32 instr_code = FetchInstruction(pc);
@@ -82,6 +99,175 @@ namespace VR4300
 	}
 
 
+	bool IsIdle()
+	{
+		return idle_loop_detected && !exception_has_occurred;
+	}
+
+
+	bool IsIdleLoop(u64 branch_pc, u64 target_address)
+	{
+		/* Only loops in the directly mapped segments kseg0/kseg1 are considered, so that instructions and
+		   polled addresses can be translated without touching the TLB or signaling exceptions. */
+		auto to_physical = [](u64 vaddr, u32& paddr) {
+			if (vaddr != u64(s32(vaddr)) || (vaddr & 0xC000'0000) != 0x8000'0000) {
+				return false;
+			}
+			paddr = u32(vaddr & 0x1FFF'FFFF);
+			return true;
+		};
+
+		u32 branch_paddr;
+		if (!to_physical(branch_pc, branch_paddr) || non_idle_loops.contains(branch_paddr)
+			|| timed_register_poll_loops.contains(branch_paddr)) {
+			return false;
+		}
+		/* Instructions are read straight from RDRAM or the rom, so that no IO is logged or has side effects */
+		auto read_instr = [](u32 paddr, u32& instr) {
+			if (paddr < RDRAM::GetSize()) {
+				instr = RDRAM::Read<s32>(paddr);
+				return true;
+			}
+			if (paddr >= 0x1000'0000 && paddr <= 0x1FBF'FFFF && Cart::GetPointerToRom(paddr)) {
+				instr = Cart::ReadRom<s32>(paddr);
+				return true;
+			}
+			return false;
+		};
+
+		/* Order of execution within one iteration: target, ..., branch, delay slot. */
+		std::array<u32, max_idle_loop_instructions> instrs;
+		uint num_instrs = uint(branch_pc - target_address) / 4 + 2;
+		for (uint i = 0; i < num_instrs; ++i) {
+			u32 paddr;
+			if (!to_physical(target_address + 4 * i, paddr) || !read_instr(paddr, instrs[i])) {
+				non_idle_loops.insert(branch_paddr);
+				return false;
+			}
+		}
+
+		/* Registers written anywhere in the loop must be written before they are read within an iteration.
+		   Otherwise, an iteration depends on the previous one (e.g. a counter), and the loop is not idle.
+		   Register values are also tracked where possible, so that load addresses can be checked. */
+		u32 written_regs = 0, written_so_far = 0, known_regs = 0;
+		std::array<u64, 32> reg_values;
+		for (uint i = 0; i < num_instrs; ++i) {
+			u32 instr = instrs[i];
+			u32 rs = instr >> 21 & 31, rt = instr >> 16 & 31, rd = instr >> 11 & 31;
+			u32 opcode = instr >> 26;
+			if (opcode == 0) {
+				written_regs |= 1 << rd;
+			}
+			else if ((opcode >= 0b001001 && opcode <= 0b001111) || opcode == 0b011001 || opcode >= 0b100000) {
+				written_regs |= 1 << rt;
+			}
+		}
+		written_regs &= ~1;
+		for (uint i = 0; i < 32; ++i) {
+			if (!(written_regs & 1 << i)) {
+				known_regs |= 1 << i;
+				reg_values[i] = gpr[i];
+			}
+		}
+
+		auto reads_loop_carried_reg = [&](u32 reg) {
+			return (written_regs & 1 << reg) && !(written_so_far & 1 << reg);
+		};
+
+		for (uint i = 0; i < num_instrs; ++i) {
+			u32 instr = instrs[i];
+			u32 rs = instr >> 21 & 31, rt = instr >> 16 & 31, rd = instr >> 11 & 31;
+			u32 opcode = instr >> 26;
+			s16 imm16 = s16(instr & 0xFFFF);
+			bool is_branch = i == num_instrs - 2;
+			bool static_ok = [&] {
+				if (is_branch) {
+					switch (opcode) {
+					case 0b000001: /* REGIMM; BLTZ, BGEZ, BLTZL, BGEZL */
+						return rt <= 0b00011;
+					case 0b000010: /* J */
+					case 0b000100: case 0b000101: case 0b000110: case 0b000111: /* BEQ, BNE, BLEZ, BGTZ */
+					case 0b010100: case 0b010101: case 0b010110: case 0b010111: /* BEQL, BNEL, BLEZL, BGTZL */
+						return true;
+					default:
+						return false;
+					}
+				}
+				switch (opcode) {
+				case 0b000000: /* SPECIAL; shifts and logical/arithmetic operations that cannot trap */
+					switch (instr & 0x3F) {
+					case 0b000000: case 0b000010: case 0b000011: case 0b000100: case 0b000110: case 0b000111: /* SLL, SRL, SRA, SLLV, SRLV, SRAV */
+					case 0b010100: case 0b010110: case 0b010111: /* DSLLV, DSRLV, DSRAV */
+					case 0b100001: case 0b100011: case 0b100100: case 0b100101: case 0b100110: case 0b100111: /* ADDU, SUBU, AND, OR, XOR, NOR */
+					case 0b101010: case 0b101011: case 0b101101: case 0b101111: /* SLT, SLTU, DADDU, DSUBU */
+					case 0b111000: case 0b111010: case 0b111011: case 0b111100: case 0b111110: case 0b111111: /* DSLL, DSRL, DSRA, DSLL32, DSRL32, DSRA32 */
+						return true;
+					default:
+						return false;
+					}
+				case 0b001001: case 0b001010: case 0b001011: case 0b001100: /* ADDIU, SLTI, SLTIU, ANDI */
+				case 0b001101: case 0b001110: case 0b001111: case 0b011001: /* ORI, XORI, LUI, DADDIU */
+				case 0b100000: case 0b100001: case 0b100011: case 0b100100: /* LB, LH, LW, LBU */
+				case 0b100101: case 0b100111: case 0b110111: /* LHU, LWU, LD */
+					return true;
+				default:
+					return false;
+				}
+			}();
+			bool uses_rt = opcode == 0 || opcode == 0b000100 || opcode == 0b000101 || opcode == 0b010100 || opcode == 0b010101;
+			bool uses_rs = opcode != 0b000010 && opcode != 0b001111;
+			if (!static_ok || (uses_rs && reads_loop_carried_reg(rs)) || (uses_rt && reads_loop_carried_reg(rt))) {
+				non_idle_loops.insert(branch_paddr);
+				return false;
+			}
+			if (is_branch) {
+				continue;
+			}
+
+			u32 dst = opcode == 0 ? rd : rt;
+			bool dst_known = false;
+			u64 dst_value = 0;
+			if (opcode >= 0b100000) { /* load */
+				u32 load_paddr;
+				if (!(known_regs & 1 << rs) || !to_physical(reg_values[rs] + imm16, load_paddr)) {
+					non_idle_loops.insert(branch_paddr);
+					return false;
+				}
+				if (load_paddr >= 0x0440'0000 && load_paddr <= 0x045F'FFFF) { /* VI, AI */
+					timed_register_poll_loops.insert(branch_paddr);
+					return false;
+				}
+			}
+			else if (opcode == 0b001111) { /* LUI */
+				dst_known = true;
+				dst_value = s64(imm16) << 16;
+			}
+			else if (known_regs & 1 << rs) {
+				dst_known = true;
+				switch (opcode) {
+				case 0b001001: dst_value = s64(s32(reg_values[rs] + imm16)); break; /* ADDIU */
+				case 0b001100: dst_value = reg_values[rs] & u16(imm16); break; /* ANDI */
+				case 0b001101: dst_value = reg_values[rs] | u16(imm16); break; /* ORI */
+				case 0b001110: dst_value = reg_values[rs] ^ u16(imm16); break; /* XORI */
+				case 0b011001: dst_value = reg_values[rs] + imm16; break; /* DADDIU */
+				default: dst_known = false;
+				}
+			}
+			if (dst != 0) {
+				written_so_far |= 1 << dst;
+				if (dst_known) {
+					known_regs |= 1 << dst;
+					reg_values[dst] = dst_value;
+				}
+				else {
+					known_regs &= ~(1 << dst);
+				}
+			}
+		}
+		return true;
+	}
+
+
 	void InitRun(bool hle_pif)
 	{
 		if (hle_pif) {
@@ -105,6 +291,24 @@ namespace VR4300
 	}
 
 
+	void InterpretInstruction()
+	{
+		if (jump_is_pending) {
+			if (instructions_until_jump == 0) {
+				TakePendingJump();
+			}
+			else {
+				--instructions_until_jump;
+				in_branch_delay_slot = true;
+			}
+		}
+		FetchDecodeExecuteInstruction();
+		if (exception_has_occurred) {
+			HandleException();
+		}
+	}
+
+
 	void NotifyIllegalInstrCode(u32 instr_code)
 	{
 		Log::Error(std::format("Illegal CPU instruction code {:08X} encountered.\n", instr_code));
@@ -116,11 +320,22 @@ namespace VR4300
 		rdram_ptr = RDRAM::GetPointerToMemory();
 		exception_has_occurred = false;
 		jump_is_pending = false;
+		idle_loop_detected = false;
+		last_jump_pc = 0;
+		non_idle_loops.clear();
+		timed_register_poll_loops.clear();
 
 		InitializeRegisters();
 		InitializeFpu();
 		InitializeMMU();
 
+		if constexpr (instruction_histograms) {
+			cpu_instr_histogram.Reset();
+			cop0_instr_histogram.Reset();
+			cop1_instr_histogram.Reset();
+			cop2_instr_histogram.Reset();
+		}
+
 		if constexpr (recompile_cpu) {
 			Recompiler::Initialize();
 		}
@@ -132,6 +347,9 @@ namespace VR4300
 		jump_is_pending = true;
 		instructions_until_jump = 1;
 		addr_to_jump_to = target_address;
+		if constexpr (skip_idle_loops) {
+			DetectIdleLoop(pc - 4, target_address);
+		}
 	}
 
 
@@ -146,21 +364,20 @@ namespace VR4300
 
 	u64 Run(u64 cpu_cycles_to_run)
 	{
+		if constexpr (tiered_cpu) {
+			return Recompiler::Run(cpu_cycles_to_run);
+		}
 		p_cycle_counter = 0;
+		idle_loop_detected = false;
 		while (p_cycle_counter < cpu_cycles_to_run) {
-			if (jump_is_pending) {
-				if (instructions_until_jump-- == 0) {
-					pc = addr_to_jump_to;
-					jump_is_pending = false;
-					in_branch_delay_slot = false;
-				}
-				else {
-					in_branch_delay_slot = true;
+			InterpretInstruction();
+			if (idle_loop_detected) {
+				/* Nothing that the loop polls can change before the end of this step */
+				if (p_cycle_counter < cpu_cycles_to_run) {
+					cop0.count += cpu_cycles_to_run - p_cycle_counter;
+					p_cycle_counter = cpu_cycles_to_run;
 				}
-			}
-			FetchDecodeExecuteInstruction();
-			if (exception_has_occurred) {
-				HandleException();
+				break;
 			}
 		}
 		return p_cycle_counter - cpu_cycles_to_run;
@@ -172,4 +389,43 @@ namespace VR4300
 		cop0.cause.ip |= std::to_underlying(interrupt);
 		CheckInterrupts();
 	}
+
+
+	void SkipIdleCycles(u64 cycles)
+	{
+		/* Called by the scheduler while the CPU is stuck in an idle loop; only COUNT needs to advance. */
+		cop0.count += cycles;
+	}
+
+
+	void StreamState(Serializer& serializer)
+	{
+		/* The state of all partitions; the recompiler's code cache is not part of it */
+		serializer.Stream(operating_mode, in_branch_delay_slot, ll_bit, jump_is_pending, last_instr_was_load,
+			instructions_until_jump, addr_to_jump_to, pc, hi_reg, lo_reg, last_jump_pc, active_cop1_decode_fun,
+			active_cop1_load_store_decode_fun);
+		serializer.Stream(gpr, cop0, fcr31, fpr, cop2_latch);
+		serializer.Stream(addressing_mode, last_physical_address_on_load, tlb_entries,
+			active_virtual_to_physical_fun_read, active_virtual_to_physical_fun_write);
+		serializer.Stream(d_cache, i_cache);
+		serializer.Stream(occurred_exception, exception_has_occurred, occurred_exception_priority,
+			exception_bad_virt_addr, exception_vector, coprocessor_unusable_source, exception_handler);
+	}
+
+
+	void TakePendingJump()
+	{
+		pc = addr_to_jump_to;
+		jump_is_pending = false;
+		in_branch_delay_slot = false;
+	}
+
+
+	void WriteInstructionHistograms(std::ostream& os)
+	{
+		cpu_instr_histogram.WriteCsv(os, "vr4300", "cpu");
+		cop0_instr_histogram.WriteCsv(os, "vr4300", "cop0");
+		cop1_instr_histogram.WriteCsv(os, "vr4300", "cop1");
+		cop2_instr_histogram.WriteCsv(os, "vr4300", "cop2");
+	}
 }
\ No newline at end of file
@@ -5,19 +5,24 @@ import :COP0;
 import :COP1;
 import :COP2;
 
+import InstructionHistogram;
+import Serializer;
 import Util;
 
+import <array>;
 import <cstring>;
 import <format>;
+import <ostream>;
 import <string>;
 import <string_view>;
+import <unordered_set>;
 import <utility>;
 
 namespace VR4300
 {
 	export
 	{
-		enum class OperatingMode {
+		thread_local enum class OperatingMode {
 			User, Supervisor, Kernel
 		} operating_mode;
 
@@ -34,41 +39,69 @@ namespace VR4300
 		void ClearInterruptPending(ExternalInterruptSource);
 		u64 GetElapsedCycles();
 		void InitRun(bool hle_pif);
+		bool IsIdle();
 		void Reset();
 		u64 Run(u64 cpu_cycles_to_run);
 		void PowerOn();
 		void SetInterruptPending(ExternalInterruptSource);
+		void SkipIdleCycles(u64 cycles);
+		void StreamState(Serializer& serializer);
+		void WriteInstructionHistograms(std::ostream& os);
 	}
 
+	using Cop1DecodeFun = void(*)();
+
 	void AdvancePipeline(u64 cycles);
 	void DecodeExecuteCop0Instruction();
-	void DecodeExecuteCop1Instruction();
+	template<bool fr> void DecodeExecuteCop1Instruction();
+	template<bool fr> void DecodeExecuteCop1LoadStoreInstruction();
 	void DecodeExecuteCop2Instruction();
 	void DecodeExecuteCop3Instruction();
 	void DecodeExecuteInstruction(u32 instr_code);
 	void DecodeExecuteRegimmInstruction();
 	void DecodeExecuteSpecialInstruction();
+	void DetectIdleLoop(u64 branch_pc, u64 target_address);
 	template<CpuInstruction> void ExecuteCpuInstruction();
 	template<Cop0Instruction> void ExecuteCop0Instruction();
-	template<Cop1Instruction> void ExecuteCop1Instruction();
+	template<Cop1Instruction, bool fr> void ExecuteCop1Instruction();
 	template<Cop2Instruction> void ExecuteCop2Instruction();
 	void FetchDecodeExecuteInstruction();
 	void InitializeRegisters();
+	void InterpretInstruction();
+	bool IsIdleLoop(u64 branch_pc, u64 target_address);
 	void NotifyIllegalInstrCode(u32 instr_code);
 	void PrepareJump(u64 target_address);
+	void SetActiveCop1DecodeFunctions();
+	void TakePendingJump();
+
+	thread_local bool in_branch_delay_slot;
+	thread_local bool ll_bit; /* Read from / written to by load linked and store conditional instructions. */
+	thread_local bool jump_is_pending = false;
+	thread_local bool last_instr_was_load = false;
+	thread_local uint instructions_until_jump = 0;
+	thread_local u64 addr_to_jump_to;
+	thread_local u64 pc;
+	thread_local u64 hi_reg, lo_reg; /* Contain the result of a double-word multiplication or division. */
+	thread_local u64 p_cycle_counter;
+	thread_local u8* rdram_ptr;
+
+	/* Idle loop detection. A loop is idle if it is short, ends with a backward branch, and only
+	   polls memory that cannot change before the next scheduler event (e.g. MI_INTR or a RAM flag). */
+	constexpr uint max_idle_loop_instructions = 10; /* including the branch delay slot */
+	thread_local bool idle_loop_detected;
+	thread_local u64 last_jump_pc; /* address of the last branch/jump instruction taken */
+	thread_local std::unordered_set<u32> non_idle_loops; /* physical addresses of branches whose loop was found not to be idle */
+	/* Loops that poll VI_V_CURRENT or AI_LEN wait for a value that is derived from the current time, and which can be
+	   reached between two scheduler events. They are left to run, as skipping to the next event could overshoot it. */
+	thread_local std::unordered_set<u32> timed_register_poll_loops; /* physical addresses of their branches */
+
+	/* Set from cop0.status.fr, so that FGR accesses need not test the bit every time. */
+	thread_local Cop1DecodeFun active_cop1_decode_fun;
+	thread_local Cop1DecodeFun active_cop1_load_store_decode_fun;
 
-	bool in_branch_delay_slot;
-	bool ll_bit; /* Read from / written to by load linked and store conditional instructions. */
-	bool jump_is_pending = false;
-	bool last_instr_was_load = false;
-	uint instructions_until_jump = 0;
-	u64 addr_to_jump_to;
-	u64 pc;
-	u64 hi_reg, lo_reg; /* Contain the result of a double-word multiplication or division. */
-	u64 p_cycle_counter;
-	u8* rdram_ptr;
+	thread_local InstructionHistogram cpu_instr_histogram, cop0_instr_histogram, cop1_instr_histogram, cop2_instr_histogram;
 
 	/* Debugging */
-	std::string_view current_instr_name;
-	std::string current_instr_log_output;
+	thread_local std::string_view current_instr_name;
+	thread_local std::string current_instr_log_output;
 }
\ No newline at end of file
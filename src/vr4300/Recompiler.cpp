@@ -4,6 +4,7 @@ module;
 #include <windows.h>
 #else
 #include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 module VR4300:Recompiler;
@@ -12,11 +13,12 @@ import :COP0;
 import :COP1;
 import :COP2;
 import :CPU;
+import :Exceptions;
 import :MMU;
 import :Operation;
 
 import BuildOptions;
-import UserMessage;
+import Memory;
 
 namespace VR4300::Recompiler
 {
@@ -27,6 +29,15 @@ namespace VR4300::Recompiler
 	}
 
 
+	void AddBlock(u32 physical_pc, std::unique_ptr<Block> block)
+	{
+		if constexpr (write_perf_map) {
+			WritePerfMapEntry(physical_pc, *block);
+		}
+		blocks.insert({ physical_pc, std::move(block) });
+	}
+
+
 	bool AllocateBuffer()
 	{
 #ifdef _WIN64
@@ -50,27 +61,78 @@ namespace VR4300::Recompiler
 			return false;
 		}
 #endif
+		buffer_mapping.reset(buffer);
 		buffer_allocated = true;
-		buffer_end = buffer + buffer_size;
 		return true;
 	}
 
 
 	void BreakupBlock()
 	{
+		if constexpr (tiered_cpu) {
+			interpreted_block_ended = true;
+		}
 		if (current_block_buffer_pos == 0) { /* starting instruction in blocking currently being created not found yet */
 			return;
 		}
 		ret();
 		buffer_pos += current_block_buffer_pos;
-		if (buffer_pos >= buffer_end) [[unlikely]] {
-			UserMessage::Fatal("Out of memory for recompiler");
-			std::cerr << "Out of memory for recompiler\n";
-			std::exit(1);
-		}
+		++cache_stats.blocks_compiled;
 		current_block->cycle_len = current_block_cycle_counter;
 		current_block->end_virtual_pc = pc;
-		blocks.insert({ current_block_physical_start_pc, std::move(current_block) });
+		current_block->code_len = u32(current_block_buffer_pos);
+		current_block->guest_len = u32(pc - current_block_virtual_start_pc);
+		current_block->guest_hash = HashGuestCode(u32(current_block_physical_start_pc), current_block->guest_len);
+		current_block->position_independent = current_block_is_position_independent;
+		AddBlock(u32(current_block_physical_start_pc), std::move(current_block));
+	}
+
+
+	void BufferDeleter::operator()(u8* mapping) const
+	{
+#ifdef _WIN64
+		if (!VirtualFree(mapping, 0, MEM_RELEASE)) {
+			std::cerr << "VirtualFree failed with error code " << GetLastError() << '\n';
+		}
+#else
+		if (munmap(mapping, buffer_size) != 0) {
+			std::cerr << "munmap failed\n";
+		}
+#endif
+	}
+
+
+	void EvictBlocks(u8* begin, u8* end)
+	{
+		cache_stats.blocks_evicted += std::erase_if(blocks, [&](auto const& entry) {
+			return entry.second->buffer >= begin && entry.second->buffer < end;
+		});
+		++cache_stats.region_flushes;
+	}
+
+
+	std::filesystem::path GetBlockCachePath(u64 rom_hash, std::string_view file_suffix)
+	{
+		/* The suffix keeps machines that run side by side (see N64::SetOutputFileSuffix) from sharing a file */
+		return std::filesystem::path(block_cache_dir)
+			/ (file_suffix.empty() ? std::format("{:016x}.bin", rom_hash) : std::format("{:016x}.{}.bin", rom_hash, file_suffix));
+	}
+
+
+	CodeCacheStats GetCodeCacheStats()
+	{
+		return cache_stats;
+	}
+
+
+	u64 HashGuestCode(u32 physical_addr, u32 len)
+	{
+		/* FNV-1a over the instruction words */
+		u64 hash = 0xCBF2'9CE4'8422'2325;
+		for (u32 i = 0; i < len; i += 4) {
+			hash = (hash ^ u32(Memory::Read<s32>(physical_addr + i))) * 0x100'0000'01B3;
+		}
+		return hash;
 	}
 
 
@@ -80,35 +142,160 @@ namespace VR4300::Recompiler
 			return false;
 		}
 		std::memset(buffer, 0, buffer_size);
-		buffer_pos = buffer;
+		ResetBuffer();
 		blocks.clear();
+		block_profiles.clear();
 		current_block.reset();
 		return true;
 	}
 
 
+	void InterpretBlock(BlockProfile& profile, u32 physical_pc, u64 cpu_cycles_to_run)
+	{
+		/* Precondition: no jump is pending, i.e. pc is at a block entry */
+		u64 start_pc = pc, last_instr_pc;
+		interpreted_block_ended = false;
+		do {
+			last_instr_pc = pc;
+			FetchDecodeExecuteInstruction();
+			if (exception_has_occurred) {
+				HandleException();
+				return; /* the exception vector is the next block entry */
+			}
+		} while (!interpreted_block_ended && !idle_loop_detected && p_cycle_counter < cpu_cycles_to_run);
+		/* The branch delay slot, if any, is interpreted by the caller. The block ends with the instruction that ended
+		   it; pc cannot be used for that, as ERET has already moved it to the return address. */
+		if (interpreted_block_ended && profile.guest_len == 0) {
+			profile.guest_len = u32(last_instr_pc + 4 - start_pc);
+			profile.guest_hash = HashGuestCode(physical_pc, profile.guest_len);
+		}
+	}
+
+
+	void LoadBlockCache(u64 rom_hash, std::string_view file_suffix)
+	{
+		/* Blocks of a previously loaded game are of no use anymore */
+		blocks.clear();
+		block_profiles.clear();
+		current_block.reset();
+		ResetBuffer();
+		cached_blocks.clear();
+		block_cache_rom_hash = rom_hash;
+
+		std::ifstream ifs{ GetBlockCachePath(rom_hash, file_suffix), std::ios::binary };
+		if (!ifs) {
+			return;
+		}
+		BlockCacheHeader header;
+		if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != block_cache_magic
+			|| header.version != block_cache_version || header.rom_hash != rom_hash) {
+			return;
+		}
+		for (BlockCacheEntry entry; ifs.read(reinterpret_cast<char*>(&entry), sizeof(entry)); ) {
+			if (entry.code_len > max_block_code_size) { /* corrupt; what follows cannot be trusted either */
+				break;
+			}
+			std::vector<u8> code(entry.code_len);
+			if (!ifs.read(reinterpret_cast<char*>(code.data()), entry.code_len)) {
+				break;
+			}
+			cached_blocks.insert({ entry.physical_pc, CachedBlock{ entry, std::move(code) } });
+		}
+	}
+
+
 	void MakeBlock(u32 physical_start_pc)
 	{
+		ReserveBufferSpace(max_block_code_size);
 		current_block = std::make_unique<Block>();
 		current_block->buffer = buffer_pos;
 		current_block_buffer_pos = 0;
 		current_block_cycle_counter = 0;
 		current_block_physical_start_pc = physical_start_pc;
+		current_block_virtual_start_pc = pc;
+		current_block_is_position_independent = true;
+	}
+
+
+	bool PromoteBlock(BlockProfile& profile, u32 physical_pc)
+	{
+		if constexpr (!emitter_complete) {
+			return false; /* the compile loop in Run waits for emitted code, and would never end */
+		}
+		if (profile.num_code_changes >= max_block_code_changes || ++profile.entry_count < block_promotion_threshold
+			|| profile.guest_len == 0) {
+			return false;
+		}
+		if (HashGuestCode(physical_pc, profile.guest_len) != profile.guest_hash) {
+			++profile.num_code_changes;
+			profile.entry_count = 0;
+			profile.guest_len = 0; /* measured and hashed anew by the next interpretation */
+			return false;
+		}
+		return true;
+	}
+
+
+	void ReserveBufferSpace(size_t size)
+	{
+		if (size_t(region_end - buffer_pos) < size) {
+			current_region = (current_region + 1) % num_buffer_regions;
+			buffer_pos = buffer + current_region * region_size;
+			region_end = buffer_pos + region_size;
+			buffer_wrapped |= current_region == 0;
+			if (buffer_wrapped) { /* before that, the region has never held code */
+				EvictBlocks(buffer_pos, region_end);
+			}
+		}
+	}
+
+
+	void ResetBuffer()
+	{
+		buffer_pos = buffer;
+		region_end = buffer + region_size;
+		current_region = 0;
+		buffer_wrapped = false;
+		cache_stats = {};
 	}
 
 
 	u64 Run(u64 cpu_cycles_to_run)
 	{
 		p_cycle_counter = 0;
-		while (p_cycle_counter < cpu_cycles_to_run) {
+		idle_loop_detected = false;
+		while (p_cycle_counter < cpu_cycles_to_run && !idle_loop_detected) {
+			if constexpr (tiered_cpu) {
+				/* Blocks start at jump targets. The delay slot of an interpreted branch is interpreted as well. */
+				if (jump_is_pending) {
+					if (instructions_until_jump > 0) {
+						InterpretInstruction();
+						continue;
+					}
+					TakePendingJump();
+				}
+			}
 			u32 physical_pc = GetPhysicalPC();
 			if (auto block_it = blocks.find(physical_pc); block_it != blocks.end()) {
+				++cache_stats.block_hits;
 				block_it->second->Execute();
 				pc = block_it->second->end_virtual_pc;
 				p_cycle_counter += block_it->second->cycle_len;
 			}
 			else {
 				if (!current_block) {
+					if constexpr (persist_recompiled_blocks) {
+						if (TryLoadCachedBlock(physical_pc)) {
+							continue;
+						}
+					}
+					if constexpr (tiered_cpu) {
+						BlockProfile& profile = block_profiles[physical_pc];
+						if (!PromoteBlock(profile, physical_pc)) {
+							InterpretBlock(profile, physical_pc, cpu_cycles_to_run);
+							continue;
+						}
+					}
 					MakeBlock(physical_pc);
 				}
 				while (current_block_buffer_pos < target_block_size) {
@@ -117,27 +304,130 @@ namespace VR4300::Recompiler
 				BreakupBlock();
 			}
 		}
+		if (idle_loop_detected && p_cycle_counter < cpu_cycles_to_run) {
+			cop0.count += cpu_cycles_to_run - p_cycle_counter;
+			p_cycle_counter = cpu_cycles_to_run;
+		}
 		return p_cycle_counter - cpu_cycles_to_run;
 	}
 
 
+	bool SaveBlockCache(std::string_view file_suffix)
+	{
+		if (block_cache_rom_hash == 0) { /* no game has been loaded */
+			return false;
+		}
+		/* Without new blocks to add, the file on disk (if any) already holds everything worth keeping */
+		if (std::ranges::none_of(blocks, [](auto const& entry) { return entry.second->position_independent; })) {
+			return true;
+		}
+		std::filesystem::path path = GetBlockCachePath(block_cache_rom_hash, file_suffix);
+		std::error_code ec;
+		std::filesystem::create_directories(path.parent_path(), ec);
+		/* Write to a uniquely named file and rename it over the cache file, so that concurrent runs of the same
+		   rom never read a partially written cache */
+		std::filesystem::path tmp_path = path;
+		tmp_path += std::format(".{:08x}.tmp", std::random_device{}());
+		{
+			std::ofstream ofs{ tmp_path, std::ios::binary | std::ios::trunc };
+			if (!ofs) {
+				return false;
+			}
+			BlockCacheHeader header = {
+				.magic = block_cache_magic,
+				.version = block_cache_version,
+				.rom_hash = block_cache_rom_hash
+			};
+			ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			auto WriteBlock = [&](BlockCacheEntry const& entry, u8 const* code) {
+				ofs.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+				ofs.write(reinterpret_cast<const char*>(code), entry.code_len);
+			};
+			for (auto const& [physical_pc, block] : blocks) {
+				if (block->position_independent) {
+					WriteBlock({
+						.physical_pc = u32(physical_pc),
+						.code_len = block->code_len,
+						.guest_len = block->guest_len,
+						.guest_hash = block->guest_hash,
+						.cycle_len = block->cycle_len,
+						.end_virtual_pc = block->end_virtual_pc
+					}, block->buffer);
+				}
+			}
+			/* Keep the cached blocks that were never reached in this run */
+			for (auto const& [physical_pc, cached_block] : cached_blocks) {
+				if (!blocks.contains(physical_pc)) {
+					WriteBlock(cached_block.entry, cached_block.code.data());
+				}
+			}
+			if (!ofs) {
+				ofs.close();
+				std::filesystem::remove(tmp_path, ec);
+				return false;
+			}
+		}
+		std::filesystem::rename(tmp_path, path, ec);
+		if (ec) {
+			std::filesystem::remove(tmp_path, ec);
+			return false;
+		}
+		return true;
+	}
+
+
 	bool Terminate()
 	{
-#ifdef _WIN64
-		if (buffer && !VirtualFree(buffer, buffer_size, MEM_RELEASE)) {
-			std::cerr << "VirtualFree failed with error code " << GetLastError() << '\n';
+		blocks.clear();
+		buffer_mapping.reset();
+		buffer = nullptr;
+		buffer_allocated = false;
+		return true;
+	}
+
+
+	bool TryLoadCachedBlock(u32 physical_pc)
+	{
+		/* Precondition: no block is being made, as the code is copied to the current end of the buffer */
+		auto it = cached_blocks.find(physical_pc);
+		if (it == cached_blocks.end()) {
 			return false;
 		}
-#else
-		if (buffer & !munmap(buffer, buffer_size)) {
-			std::cerr << "munmap failed\n";
+		CachedBlock cached_block = std::move(it->second);
+		cached_blocks.erase(it); /* if it does not validate, the block gets recompiled, which replaces it on disk */
+		BlockCacheEntry const& entry = cached_block.entry;
+		if (entry.code_len > max_block_code_size || HashGuestCode(physical_pc, entry.guest_len) != entry.guest_hash) {
 			return false;
 		}
-#endif
+		ReserveBufferSpace(entry.code_len);
+		std::memcpy(buffer_pos, cached_block.code.data(), entry.code_len);
+		AddBlock(physical_pc, std::make_unique<Block>(Block{
+			.buffer = buffer_pos,
+			.cycle_len = entry.cycle_len,
+			.end_virtual_pc = entry.end_virtual_pc,
+			.code_len = entry.code_len,
+			.guest_len = entry.guest_len,
+			.guest_hash = entry.guest_hash,
+			.position_independent = true
+		}));
+		buffer_pos += entry.code_len;
 		return true;
 	}
 
 
+	void WritePerfMapEntry(u32 physical_pc, Block const& block)
+	{
+#ifndef _WIN64
+		std::scoped_lock lock{ perf_map_mutex };
+		if (!perf_map.is_open()) {
+			perf_map.open(std::format("/tmp/perf-{}.map", getpid()), std::ios::trunc);
+		}
+		perf_map << std::format("{:x} {:x} vr4300_{:08X}\n", u64(block.buffer), block.code_len, physical_pc);
+		perf_map.flush(); /* perf reads the file after the process has exited, possibly without unwinding */
+#endif
+	}
+
+
 	void emit(u8 byte)
 	{
 		current_block->buffer[current_block_buffer_pos++] = byte;
@@ -146,6 +436,7 @@ namespace VR4300::Recompiler
 
 	void call(const auto* fun_ptr)
 	{
+		current_block_is_position_independent = false; /* the target is an absolute host address */
 		if constexpr (Host::is_x64) {
 			emit(0xFF);
 		}
@@ -158,4 +449,4 @@ namespace VR4300::Recompiler
 			/* TODO */
 		}
 	}
-}
\ No newline at end of file
+}
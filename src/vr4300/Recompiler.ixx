@@ -2,47 +2,161 @@ export module VR4300:Recompiler;
 
 import Util;
 
+import <algorithm>;
+import <array>;
 import <bit>;
 import <cstdlib>;
 import <cstring>;
+import <filesystem>;
+import <format>;
+import <fstream>;
 import <iostream>;
 import <iterator>;
 import <memory>;
+import <mutex>;
+import <random>;
+import <string_view>;
 import <unordered_map>;
 import <utility>;
+import <vector>;
 
 namespace VR4300::Recompiler
 {
 	export
 	{
+		struct CodeCacheStats {
+			u64 block_hits; /* executions of compiled blocks */
+			u64 blocks_compiled;
+			u64 blocks_evicted;
+			u64 region_flushes;
+		};
+
+		CodeCacheStats GetCodeCacheStats();
 		bool Initialize();
+		void LoadBlockCache(u64 rom_hash, std::string_view file_suffix = {});
 		u64 Run(u64 cpu_cycles_to_run);
+		bool SaveBlockCache(std::string_view file_suffix = {});
 		bool Terminate();
 	}
 
+	struct Block;
+	struct BlockProfile;
+
+	void AddBlock(u32 physical_pc, std::unique_ptr<Block> block);
 	bool AllocateBuffer();
 	void BreakupBlock();
+	void EvictBlocks(u8* begin, u8* end);
+	std::filesystem::path GetBlockCachePath(u64 rom_hash, std::string_view file_suffix);
+	u64 HashGuestCode(u32 physical_addr, u32 len);
+	void InterpretBlock(BlockProfile& profile, u32 physical_pc, u64 cpu_cycles_to_run);
 	void MakeBlock(u32 physical_start_pc);
+	bool PromoteBlock(BlockProfile& profile, u32 physical_pc);
+	void ReserveBufferSpace(size_t size);
+	void ResetBuffer();
+	bool TryLoadCachedBlock(u32 physical_pc);
+	void WritePerfMapEntry(u32 physical_pc, Block const& block);
+
+	struct BufferDeleter {
+		void operator()(u8* mapping) const;
+	};
 
 	struct Block {
 		u8* buffer;
 		u64 cycle_len;
 		u64 end_virtual_pc;
+		u32 code_len; /* bytes of host code */
+		u32 guest_len; /* bytes of guest code the block was compiled from, starting at its physical address */
+		u64 guest_hash; /* of those bytes */
+		bool position_independent; /* false if the host code embeds absolute host addresses, e.g. of functions */
 		void Execute() const;
 	};
 
+	/* Persistent block cache. When a game is stopped, the position-independent blocks are written to a file named
+	   after the rom hash, together with the physical address and a hash of the guest code of each. On the next
+	   launch of the same rom the file is read, and a cached block is used as soon as execution reaches its address
+	   and the guest code there hashes the same; the code is then copied into the code buffer instead of recompiled.
+	   File layout: BlockCacheHeader, then for every block a BlockCacheEntry followed by 'code_len' bytes of code. */
+	struct BlockCacheHeader {
+		std::array<char, 4> magic;
+		u32 version;
+		u64 rom_hash;
+	};
+
+	struct BlockCacheEntry {
+		u32 physical_pc;
+		u32 code_len;
+		u32 guest_len;
+		u32 padding;
+		u64 guest_hash;
+		u64 cycle_len;
+		u64 end_virtual_pc;
+	};
+
+	struct CachedBlock {
+		BlockCacheEntry entry;
+		std::vector<u8> code;
+	};
+
+	/* Tiered execution. Code is interpreted one block at a time, a block ending with the first branch, jump or
+	   exception, and the number of times every block entry is reached is counted. The block at an entry that has
+	   been reached 'block_promotion_threshold' times is compiled. Before that, its guest code is hashed again and
+	   compared to the hash taken when it was first interpreted; if it differs, the code is being rewritten (e.g.
+	   overlays, or self-modifying code), and the count starts over. After 'max_block_code_changes' such changes,
+	   the block is left to the interpreter for good. */
+	struct BlockProfile {
+		u32 entry_count;
+		u32 num_code_changes;
+		u32 guest_len; /* 0 until the block has been interpreted to its end */
+		u64 guest_hash;
+	};
+
+	constexpr u32 block_promotion_threshold = 64;
+	constexpr u32 max_block_code_changes = 4;
+	constexpr bool emitter_complete = false; /* ret() and the instruction emitters are stubs; nothing is promoted until they are done */
+
+	/* The code buffer is split into regions, which are filled one after the other. When the last one is full, the
+	   first one is flushed, i.e. the blocks in it are evicted from the block table, and compilation continues there;
+	   so it always is the oldest code that gets thrown out. A block never straddles two regions. */
 	constexpr size_t buffer_size = 32 * 1024 * 1024;
+	constexpr uint num_buffer_regions = 8;
+	constexpr size_t region_size = buffer_size / num_buffer_regions;
 	constexpr size_t target_block_size = 256;
+	constexpr size_t max_instr_code_size = 64;
+	constexpr size_t max_block_code_size = target_block_size + max_instr_code_size;
+
+	constexpr std::array<char, 4> block_cache_magic = { 'N', '6', 'J', 'C' };
+	constexpr u32 block_cache_version = 1; /* bump whenever the emitted code changes */
+	constexpr std::string_view block_cache_dir = "jit_cache";
+
+	thread_local u8* buffer;
+	thread_local u8* buffer_pos;
+	thread_local u8* region_end;
+	thread_local uint current_region;
+	thread_local bool buffer_wrapped;
+	thread_local CodeCacheStats cache_stats;
+	thread_local bool buffer_allocated;
+	thread_local std::unique_ptr<u8, BufferDeleter> buffer_mapping; /* owns 'buffer'; unmaps it when the thread exits */
+	thread_local u64 current_block_cycle_counter;
+	thread_local u64 current_block_physical_start_pc;
+	thread_local u64 current_block_virtual_start_pc;
+	thread_local size_t current_block_buffer_pos;
+	thread_local bool current_block_is_position_independent;
+	thread_local std::unique_ptr<Block> current_block; /* TODO: allocate all memory upfront */
+	thread_local std::unordered_map<u64, std::unique_ptr<Block>> blocks; /* physical address => instruction block */
+
+	thread_local bool interpreted_block_ended;
+	thread_local std::unordered_map<u32, BlockProfile> block_profiles; /* physical address => profile */
+
+	/* perf map (see tools/perf/Documentation/jit-interface.txt in the Linux source tree). With 'write_perf_map' set,
+	   every block added to the block table is appended to /tmp/perf-<pid>.map as 'vr4300_<physical pc>', so that
+	   'perf report' can attribute samples in the code buffer to guest code. The file is shared by all machines of
+	   the process. perf has no notion of code being unmapped; after a region flush, samples in the reused part of
+	   the buffer may be attributed to an evicted block as well as to the block that replaced it. */
+	std::mutex perf_map_mutex;
+	std::ofstream perf_map;
 
-	u8* buffer;
-	u8* buffer_end;
-	u8* buffer_pos;
-	bool buffer_allocated;
-	u64 current_block_cycle_counter;
-	u64 current_block_physical_start_pc;
-	size_t current_block_buffer_pos;
-	std::unique_ptr<Block> current_block; /* TODO: allocate all memory upfront */
-	std::unordered_map<u64, std::unique_ptr<Block>> blocks; /* physical address => instruction block */
+	thread_local u64 block_cache_rom_hash;
+	thread_local std::unordered_map<u32, CachedBlock> cached_blocks; /* read from the cache file, not yet validated */
 
 	void call(const auto* fun_ptr);
 	void ret();
@@ -1,5 +1,6 @@
 export module VR4300;
 
+export import :Benchmarks;
 export import :Cache;
 export import :COP0;
 export import :COP1;